@@ -0,0 +1,129 @@
+#include "arena.h"
+
+#include <SDL3/SDL.h>
+#include <assert.h>
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t capacity;
+    size_t offset;
+    alignas(ARENA_ALIGNMENT) unsigned char data[];
+};
+
+static SDL_AtomicInt heap_allocations;
+
+static SDL_malloc_func original_malloc;
+static SDL_calloc_func original_calloc;
+static SDL_realloc_func original_realloc;
+static SDL_free_func original_free;
+
+static ArenaBlock *arena_block_create(size_t capacity) {
+    ArenaBlock *block = heap_alloc(sizeof(ArenaBlock) + capacity);
+    assert(block);
+    block->next = NULL;
+    block->capacity = capacity;
+    block->offset = 0;
+    return block;
+}
+
+void arena_init(Arena *arena, size_t block_size) {
+    *arena = (Arena){0};
+    arena->block_size = block_size;
+    arena->first = arena->current = arena_block_create(block_size);
+    arena->blocks_count = 1;
+}
+
+// Never returns NULL, every allocation is aligned to ARENA_ALIGNMENT.
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t offset = (arena->current->offset + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    while (offset + size > arena->current->capacity) {
+        ArenaBlock *next = arena->current->next;
+        if (next == NULL || next->capacity < size) {
+            // Oversized requests get a block of their own, spliced in so the blocks after it are still reused.
+            next = arena_block_create(SDL_max(arena->block_size, size));
+            next->next = arena->current->next;
+            arena->current->next = next;
+            arena->blocks_count++;
+        }
+        arena->current = next;
+        arena->current->offset = 0;
+        offset = 0;
+    }
+
+    arena->current->offset = offset + size;
+    arena->used += size;
+    arena->peak = SDL_max(arena->peak, arena->used);
+    return arena->current->data + offset;
+}
+
+void *arena_alloc_zero(Arena *arena, size_t size) {
+    void *data = arena_alloc(arena, size);
+    memset(data, 0, size);
+    return data;
+}
+
+ArenaMark arena_mark(const Arena *arena) {
+    return (ArenaMark){.block = arena->current, .offset = arena->current->offset, .used = arena->used};
+}
+
+// Frees everything allocated after `mark` was taken.
+void arena_rewind(Arena *arena, ArenaMark mark) {
+    arena->current = mark.block;
+    arena->current->offset = mark.offset;
+    arena->used = mark.used;
+}
+
+void arena_reset(Arena *arena) {
+    arena->current = arena->first;
+    arena->current->offset = 0;
+    arena->used = 0;
+}
+
+void arena_free(Arena *arena) {
+    ArenaBlock *block = arena->first;
+    while (block) {
+        ArenaBlock *next = block->next;
+        heap_free(block);
+        block = next;
+    }
+    *arena = (Arena){0};
+}
+
+uint32_t heap_allocations_count(void) { return (uint32_t)SDL_GetAtomicInt(&heap_allocations); }
+
+void *heap_alloc(size_t size) {
+    SDL_AddAtomicInt(&heap_allocations, 1);
+    return malloc(size);
+}
+
+void heap_free(void *ptr) { free(ptr); }
+
+static void *SDLCALL counted_malloc(size_t size) {
+    SDL_AddAtomicInt(&heap_allocations, 1);
+    return original_malloc(size);
+}
+
+static void *SDLCALL counted_calloc(size_t count, size_t size) {
+    SDL_AddAtomicInt(&heap_allocations, 1);
+    return original_calloc(count, size);
+}
+
+static void *SDLCALL counted_realloc(void *ptr, size_t size) {
+    SDL_AddAtomicInt(&heap_allocations, 1);
+    return original_realloc(ptr, size);
+}
+
+static void SDLCALL counted_free(void *ptr) { original_free(ptr); }
+
+// Has to run before anything else in SDL allocates, i.e. before SDL_Init.
+void heap_track_sdl_allocations(void) {
+    SDL_GetOriginalMemoryFunctions(&original_malloc, &original_calloc, &original_realloc, &original_free);
+    if (!SDL_SetMemoryFunctions(counted_malloc, counted_calloc, counted_realloc, counted_free))
+        fprintf(stderr, "ERROR: SDL_SetMemoryFunctions failed: %s\n", SDL_GetError());
+}
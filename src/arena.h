@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+/*
+ * Linear allocator. Allocations are never freed one by one, the whole arena is reset at once (or rewound to a mark).
+ * Memory comes from a chain of blocks that survive resets, so once an arena has grown to its peak it stops touching
+ * the heap.
+ */
+typedef struct {
+    ArenaBlock *first;
+    ArenaBlock *current;
+    size_t block_size;
+    // Bytes handed out since the last reset, and the most there ever was.
+    size_t used;
+    size_t peak;
+    size_t blocks_count;
+} Arena;
+
+typedef struct {
+    ArenaBlock *block;
+    size_t offset;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena *arena, size_t block_size);
+void *arena_alloc(Arena *arena, size_t size);
+void *arena_alloc_zero(Arena *arena, size_t size);
+ArenaMark arena_mark(const Arena *arena);
+void arena_rewind(Arena *arena, ArenaMark mark);
+void arena_reset(Arena *arena);
+void arena_free(Arena *arena);
+
+#define arena_push_array(arena, type, count) ((type *)arena_alloc((arena), sizeof(type) * (count)))
+
+// Counts every heap allocation made by arenas and, once hooked up, by SDL. For checking steady state frames.
+// Wraps around, take differences between two counts in uint32_t.
+uint32_t heap_allocations_count(void);
+void *heap_alloc(size_t size);
+void heap_free(void *ptr);
+void heap_track_sdl_allocations(void);
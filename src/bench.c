@@ -0,0 +1,483 @@
+#include "arena.h"
+#include "camera.h"
+#include "constants.h"
+#include "dungeon.h"
+#include "mesh.h"
+#include "sprite.h"
+
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Headless timings of the CPU side of a frame and of level loading, sized like the game runs them. No window and no
+ * GPU device, so it runs anywhere the tests do.
+ *
+ *   dung_bench [--json PATH] [--baseline PATH] [--tolerance FRACTION] [--filter SUBSTRING]
+ *
+ * --json writes the results in the format --baseline reads back, so a stored run of it is the baseline. Any benchmark
+ * whose fastest sample got slower than the baseline's by more than the tolerance (25% by default, twice that for
+ * threaded work) fails the run with exit code 1. The fastest sample is compared rather than the median since it's far
+ * less sensitive to whatever else the machine is doing, and a benchmark that looks slower is measured again before it
+ * counts. Without the baseline file there's nothing to compare, the run exits with BENCH_SKIPPED, which ctest reports
+ * as a skipped test.
+ *
+ * Before timing anything it checks dungeon_generate's promises: the same tiles whatever the thread count, and a
+ * 1024x1024 map well under a second. Breaking either fails the run too.
+ */
+
+#define BENCH_MIN_SAMPLES 15
+#define BENCH_MAX_SAMPLES 1000
+#define BENCH_MIN_NS 250000000ull
+#define BENCH_MAX_RESULTS 16
+// Extra passes before a regression counts, and when recording a baseline.
+#define BENCH_RETRIES 2
+#define BENCH_CAMERA_STEPS 10000
+#define BENCH_LARGE_DUNGEON_SIZE 1024
+#define BENCH_LARGE_DUNGEON_BUDGET_NS 1000000000ull
+// Exit code for a run without its baseline, the test's SKIP_RETURN_CODE.
+#define BENCH_SKIPPED 77
+
+typedef struct {
+    // Lives for the whole run, inputs shared by every benchmark.
+    Arena arena;
+    // Rewound after every sample.
+    Arena scratch;
+
+    Camera camera;
+    DungeonParams dungeon_params;
+    DungeonParams large_dungeon_params;
+    Dungeon dungeon;
+    Mesh dungeon_mesh;
+    Sprite *sprites;
+    size_t sprites_count;
+    // Every sprite in order, so packing doesn't depend on what the camera happens to see.
+    uint32_t *all_sprites;
+    uint32_t *visible;
+
+    // Stand ins for mapped transfer buffers, sized like the real ones.
+    SpriteVertex *sprite_transfer;
+    void *mesh_transfer;
+
+    // Written by every benchmark so the compiler can't drop the work.
+    volatile uint64_t sink;
+} BenchState;
+
+typedef struct {
+    const char *name;
+    // Runs the work once and returns how many items it processed, for the per item time.
+    size_t (*run)(BenchState *state);
+    // Scales the tolerance. Threaded work suffers more from anything else running on the machine.
+    float noise;
+} Benchmark;
+
+typedef struct {
+    char name[64];
+    size_t items;
+    size_t samples;
+    uint64_t median_ns;
+    uint64_t min_ns;
+    // Allowed slowdown against the baseline, not written to the results file.
+    float tolerance;
+} BenchResult;
+
+// Works on a copy so the culling and packing benchmarks keep seeing the start camera.
+static size_t bench_camera_update(BenchState *state) {
+    Camera camera = state->camera;
+    // Moves go back and forth so the camera stays near the level.
+    for (int i = 0; i < BENCH_CAMERA_STEPS; i += 4) {
+        bool back = (i / 4) & 1;
+        CameraDirection direction = back ? CAMERA_DIRECTION_LEFT : CAMERA_DIRECTION_RIGHT;
+        camera_rotate_around_point(&camera, camera.target, direction, 0.5f);
+        camera_strafe(&camera, direction, 0.5f);
+        camera_zoom(&camera, back ? CAMERA_ZOOM_OUT : CAMERA_ZOOM_IN, 0.5f);
+        camera_set_view(&camera);
+    }
+    state->sink += (uint64_t)camera.mvp[3][0];
+    return BENCH_CAMERA_STEPS;
+}
+
+static size_t bench_dungeon_generate(BenchState *state) {
+    Dungeon dungeon;
+    dungeon_generate(&dungeon, &state->scratch, 1, &state->dungeon_params);
+    state->sink += dungeon.tiles[0];
+    return (size_t)dungeon.width * dungeon.height;
+}
+
+static size_t bench_dungeon_generate_large(BenchState *state) {
+    Dungeon dungeon;
+    dungeon_generate(&dungeon, &state->scratch, 1, &state->large_dungeon_params);
+    state->sink += dungeon.tiles[0];
+    return (size_t)dungeon.width * dungeon.height;
+}
+
+static size_t bench_mesh_build_grid(BenchState *state) {
+    const vec4 white = {1, 1, 1, 1};
+    Mesh grid;
+    mesh_build_grid(&grid, &state->scratch, DUNGEON_SIZE + 1, 0, DUNGEON_TILE_SIZE, white);
+    state->sink += grid.indices[grid.indices_count - 1];
+    return grid.vertices_count;
+}
+
+static size_t bench_mesh_build_dungeon(BenchState *state) {
+    Mesh mesh;
+    mesh_build_dungeon(&mesh, &state->scratch, &state->dungeon, DUNGEON_TILE_SIZE, DUNGEON_WALL_HEIGHT);
+    state->sink += mesh.indices_count;
+    return mesh.indices_count / 3;
+}
+
+// Includes copying the unoptimized mesh into scratch, which is small next to the optimization itself.
+static size_t bench_mesh_optimize(BenchState *state) {
+    const Mesh *source = &state->dungeon_mesh;
+    Mesh mesh = *source;
+    mesh.vertices = arena_push_array(&state->scratch, Vertex, source->vertices_count);
+    mesh.indices = arena_push_array(&state->scratch, uint32_t, source->indices_count);
+    memcpy(mesh.vertices, source->vertices, sizeof(Vertex) * source->vertices_count);
+    memcpy(mesh.indices, source->indices, sizeof(uint32_t) * source->indices_count);
+
+    MeshOptimizeStats stats;
+    mesh_optimize(&mesh, &state->scratch, false, &stats);
+    state->sink += stats.vertices_after;
+    return source->indices_count / 3;
+}
+
+static size_t bench_sprite_cull(BenchState *state) {
+    size_t visible_count = sprite_cull(state->sprites, state->sprites_count, &state->camera, state->visible);
+    state->sink += visible_count;
+    return state->sprites_count;
+}
+
+static size_t bench_sprite_pack(BenchState *state) {
+    size_t cursor = 0;
+    sprite_pack(state->sprite_transfer, state->sprites, state->all_sprites, state->sprites_count, &cursor,
+                &state->camera);
+    state->sink += cursor;
+    return state->sprites_count;
+}
+
+static size_t bench_mesh_pack(BenchState *state) {
+    state->sink += mesh_pack(state->mesh_transfer, &state->dungeon_mesh);
+    return state->dungeon_mesh.vertices_count;
+}
+
+static const Benchmark Benchmarks[] = {
+    {"camera_update", bench_camera_update, 1},
+    {"dungeon_generate", bench_dungeon_generate, 2},
+    {"dungeon_generate_1024", bench_dungeon_generate_large, 2},
+    {"mesh_build_grid", bench_mesh_build_grid, 1},
+    {"mesh_build_dungeon", bench_mesh_build_dungeon, 1},
+    {"mesh_optimize", bench_mesh_optimize, 1},
+    {"sprite_cull", bench_sprite_cull, 1},
+    {"sprite_pack", bench_sprite_pack, 1},
+    {"mesh_pack", bench_mesh_pack, 1},
+};
+
+// Same inputs as the game: the default level, the start camera and a full sprite batch laid out like the particles.
+static void bench_state_init(BenchState *state) {
+    *state = (BenchState){0};
+    arena_init(&state->arena, LEVEL_ARENA_BLOCK_SIZE);
+    arena_init(&state->scratch, LEVEL_ARENA_BLOCK_SIZE);
+
+    camera_init(&state->camera);
+
+    dungeon_default_params(&state->dungeon_params, DUNGEON_SIZE, DUNGEON_SIZE);
+    dungeon_default_params(&state->large_dungeon_params, BENCH_LARGE_DUNGEON_SIZE, BENCH_LARGE_DUNGEON_SIZE);
+    dungeon_generate(&state->dungeon, &state->arena, 1, &state->dungeon_params);
+    mesh_build_dungeon(&state->dungeon_mesh, &state->arena, &state->dungeon, DUNGEON_TILE_SIZE, DUNGEON_WALL_HEIGHT);
+    state->mesh_transfer = arena_alloc(&state->arena, sizeof(Vertex) * state->dungeon_mesh.vertices_count +
+                                                          sizeof(uint32_t) * state->dungeon_mesh.indices_count);
+
+    state->sprites_count = SPRITE_CAPACITY;
+    state->sprites = arena_push_array(&state->arena, Sprite, state->sprites_count);
+    state->all_sprites = arena_push_array(&state->arena, uint32_t, state->sprites_count);
+    state->visible = arena_push_array(&state->arena, uint32_t, state->sprites_count);
+    state->sprite_transfer = arena_push_array(&state->arena, SpriteVertex, state->sprites_count * 4);
+    const float extent = DUNGEON_SIZE * DUNGEON_TILE_SIZE;
+    for (size_t i = 0; i < state->sprites_count; i++) {
+        uint32_t h = (uint32_t)i * 2654435761u;
+        float fx = (h & 0xffff) / 65535.0f, fz = (h >> 16) / 65535.0f;
+        state->sprites[i] = (Sprite){
+            .position = {fx * extent, 2 + sinf((float)i) * 1.5f, fz * extent},
+            .size = {1.5f, 1.5f},
+            .uv = {0, 0, 1, 1},
+            .color = {0.4f + 0.6f * fx, 0.8f, 0.4f + 0.6f * fz, 0.8f},
+        };
+        state->all_sprites[i] = (uint32_t)i;
+    }
+}
+
+/*
+ * Generates large maps with one thread and with several other counts, including more threads than cores and counts
+ * that don't divide the regions evenly, and compares the tiles. The default thread count must also stay within the
+ * time budget, judged on the fastest seed so a burst of load doesn't fail it.
+ */
+static bool bench_check_dungeon(BenchState *state) {
+    const int threads[] = {0, 2, 3, 8, 16};
+    const size_t tiles_count = (size_t)BENCH_LARGE_DUNGEON_SIZE * BENCH_LARGE_DUNGEON_SIZE;
+    bool ok = true;
+    uint64_t fastest_ns = UINT64_MAX;
+    for (uint64_t seed = 1; seed <= 3; seed++) {
+        ArenaMark mark = arena_mark(&state->scratch);
+        DungeonParams params = state->large_dungeon_params;
+        params.num_threads = 1;
+        Dungeon reference;
+        dungeon_generate(&reference, &state->scratch, seed, &params);
+
+        for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+            params.num_threads = threads[i];
+            Dungeon dungeon;
+            uint64_t start = SDL_GetTicksNS();
+            dungeon_generate(&dungeon, &state->scratch, seed, &params);
+            if (threads[i] == 0)
+                fastest_ns = SDL_min(fastest_ns, SDL_GetTicksNS() - start);
+            if (memcmp(dungeon.tiles, reference.tiles, tiles_count) != 0) {
+                fprintf(stderr, "ERROR: dungeon seed %llu differs between 1 and %d threads (0 is one per core)\n",
+                        (unsigned long long)seed, threads[i]);
+                ok = false;
+            }
+        }
+        arena_rewind(&state->scratch, mark);
+    }
+
+    printf("dungeon check: %dx%d in %.1f ms, budget %.0f ms\n\n", BENCH_LARGE_DUNGEON_SIZE, BENCH_LARGE_DUNGEON_SIZE,
+           fastest_ns / 1e6, BENCH_LARGE_DUNGEON_BUDGET_NS / 1e6);
+    if (fastest_ns > BENCH_LARGE_DUNGEON_BUDGET_NS) {
+        fprintf(stderr, "ERROR: generating a %dx%d dungeon is over budget\n", BENCH_LARGE_DUNGEON_SIZE,
+                BENCH_LARGE_DUNGEON_SIZE);
+        ok = false;
+    }
+    return ok;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// One untimed warm up run, then samples until there are enough of them and they cover enough time.
+static void bench_run(const Benchmark *benchmark, BenchState *state, BenchResult *result) {
+    static uint64_t samples[BENCH_MAX_SAMPLES];
+
+    ArenaMark mark = arena_mark(&state->scratch);
+    result->items = benchmark->run(state);
+    arena_rewind(&state->scratch, mark);
+
+    size_t count = 0;
+    uint64_t total_ns = 0;
+    while (count < BENCH_MAX_SAMPLES && (count < BENCH_MIN_SAMPLES || total_ns < BENCH_MIN_NS)) {
+        uint64_t start = SDL_GetTicksNS();
+        benchmark->run(state);
+        samples[count] = SDL_GetTicksNS() - start;
+        total_ns += samples[count++];
+        arena_rewind(&state->scratch, mark);
+    }
+
+    qsort(samples, count, sizeof(samples[0]), compare_u64);
+    snprintf(result->name, sizeof(result->name), "%s", benchmark->name);
+    result->samples = count;
+    result->median_ns = samples[count / 2];
+    result->min_ns = samples[0];
+}
+
+// Measures again and keeps the fastest run, so a burst of load during one run doesn't stick.
+static void bench_rerun(const Benchmark *benchmark, BenchState *state, BenchResult *result) {
+    BenchResult rerun;
+    bench_run(benchmark, state, &rerun);
+    rerun.tolerance = result->tolerance;
+    if (rerun.min_ns < result->min_ns)
+        *result = rerun;
+}
+
+static const BenchResult *bench_find(const BenchResult *results, size_t results_count, const char *name) {
+    for (size_t i = 0; i < results_count; i++) {
+        if (strcmp(results[i].name, name) == 0)
+            return &results[i];
+    }
+    return NULL;
+}
+
+// A different amount of work isn't comparable, that's for the baseline to be re-recorded, not a regression.
+static bool bench_regressed(const BenchResult *result, const BenchResult *base) {
+    return base && base->items == result->items &&
+           (double)result->min_ns > (double)base->min_ns * (1.0 + result->tolerance);
+}
+
+// One benchmark per line, bench_read_results relies on it.
+static bool bench_write_results(const char *path, const BenchResult *results, size_t results_count) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: can't open %s for writing\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results_count; i++) {
+        const BenchResult *result = &results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"items\": %zu, \"samples\": %zu, \"median_ns\": %llu, \"min_ns\": %llu}%s\n",
+                result->name, result->items, result->samples, (unsigned long long)result->median_ns,
+                (unsigned long long)result->min_ns, i + 1 < results_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// Only reads what bench_write_results writes, not JSON in general.
+static size_t bench_read_results(const char *path, BenchResult *results, size_t capacity) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return 0;
+    size_t count = 0;
+    char line[512];
+    while (count < capacity && fgets(line, sizeof(line), file)) {
+        const char *name = strstr(line, "\"name\": \"");
+        const char *items = strstr(line, "\"items\": ");
+        const char *median = strstr(line, "\"median_ns\": ");
+        const char *min = strstr(line, "\"min_ns\": ");
+        if (name == NULL || items == NULL || median == NULL || min == NULL)
+            continue;
+        BenchResult *result = &results[count];
+        unsigned long long median_ns, min_ns;
+        if (sscanf(name + strlen("\"name\": \""), "%63[^\"]", result->name) != 1 ||
+            sscanf(items + strlen("\"items\": "), "%zu", &result->items) != 1 ||
+            sscanf(median + strlen("\"median_ns\": "), "%llu", &median_ns) != 1 ||
+            sscanf(min + strlen("\"min_ns\": "), "%llu", &min_ns) != 1)
+            continue;
+        result->median_ns = median_ns;
+        result->min_ns = min_ns;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+// Compares the fastest samples. Returns the number of regressions.
+static int bench_compare(const BenchResult *results, size_t results_count, const BenchResult *baseline,
+                         size_t baseline_count) {
+    int regressions = 0;
+    printf("\n%-22s %12s %12s %8s\n", "benchmark", "baseline min", "current min", "change");
+    for (size_t i = 0; i < results_count; i++) {
+        const BenchResult *result = &results[i];
+        const BenchResult *base = bench_find(baseline, baseline_count, result->name);
+        if (base == NULL) {
+            printf("%-22s %12s %12.3f %8s  new\n", result->name, "-", result->min_ns / 1e6, "-");
+            continue;
+        }
+        if (base->items != result->items) {
+            printf("%-22s %12.3f %12.3f %8s  skipped, items %zu -> %zu\n", result->name, base->min_ns / 1e6,
+                   result->min_ns / 1e6, "-", base->items, result->items);
+            continue;
+        }
+        double change = (double)result->min_ns / (double)SDL_max(base->min_ns, 1) - 1.0;
+        const char *verdict = "";
+        if (bench_regressed(result, base)) {
+            verdict = "  REGRESSION";
+            regressions++;
+        } else if (change < -result->tolerance) {
+            verdict = "  faster, consider updating the baseline";
+        }
+        printf("%-22s %12.3f %12.3f %+7.1f%%%s\n", result->name, base->min_ns / 1e6, result->min_ns / 1e6,
+               change * 100.0, verdict);
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    const char *filter = NULL;
+    float tolerance = 0.25f;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0 && has_value) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--json PATH] [--baseline PATH] [--tolerance FRACTION] [--filter SUBSTRING]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    BenchResult baseline[BENCH_MAX_RESULTS];
+    size_t baseline_count = 0;
+    bool missing_baseline = false;
+    if (baseline_path) {
+        FILE *file = fopen(baseline_path, "r");
+        missing_baseline = file == NULL;
+        if (file)
+            fclose(file);
+        baseline_count = missing_baseline ? 0 : bench_read_results(baseline_path, baseline, BENCH_MAX_RESULTS);
+        if (!missing_baseline && baseline_count == 0) {
+            fprintf(stderr, "ERROR: no benchmarks in baseline %s\n", baseline_path);
+            return 2;
+        }
+    }
+
+    // Whatever gets written may become a baseline, so it's the best of several runs.
+    bool recording = json_path && baseline_path == NULL;
+
+    // No subsystems, only what threads and timers need.
+    if (!SDL_Init(0)) {
+        fprintf(stderr, "Failed to init SDL! %s", SDL_GetError());
+        return 1;
+    }
+
+    BenchState state;
+    bench_state_init(&state);
+
+    int status = 0;
+    if ((filter == NULL || strstr("dungeon_check", filter)) && !bench_check_dungeon(&state))
+        status = 1;
+
+    BenchResult results[BENCH_MAX_RESULTS];
+    const Benchmark *benchmarks[BENCH_MAX_RESULTS];
+    size_t results_count = 0;
+    for (size_t i = 0; i < sizeof(Benchmarks) / sizeof(Benchmarks[0]); i++) {
+        if (filter && strstr(Benchmarks[i].name, filter) == NULL)
+            continue;
+        benchmarks[results_count] = &Benchmarks[i];
+        BenchResult *result = &results[results_count++];
+        bench_run(&Benchmarks[i], &state, result);
+        result->tolerance = tolerance * Benchmarks[i].noise;
+    }
+
+    // Load on a shared machine comes in bursts that can outlast all of one benchmark's samples. Retrying after the
+    // whole suite has run lands outside of them.
+    for (int retry = 0; retry < BENCH_RETRIES; retry++) {
+        for (size_t i = 0; i < results_count; i++) {
+            if (recording || bench_regressed(&results[i], bench_find(baseline, baseline_count, results[i].name)))
+                bench_rerun(benchmarks[i], &state, &results[i]);
+        }
+    }
+
+    printf("%-22s %8s %12s %12s %12s\n", "benchmark", "samples", "median ms", "min ms", "ns/item");
+    for (size_t i = 0; i < results_count; i++) {
+        const BenchResult *result = &results[i];
+        printf("%-22s %8zu %12.3f %12.3f %12.2f\n", result->name, result->samples, result->median_ns / 1e6,
+               result->min_ns / 1e6, (double)result->median_ns / (double)SDL_max(result->items, 1));
+    }
+
+    if (json_path && !bench_write_results(json_path, results, results_count))
+        status = 1;
+    if (missing_baseline) {
+        // The dungeon checks above still count, only the comparison is skipped.
+        fprintf(stderr, "\nSKIPPED: no baseline at %s, nothing was compared. Record one with --json.\n",
+                baseline_path);
+        if (status == 0)
+            status = BENCH_SKIPPED;
+    } else if (baseline_path && bench_compare(results, results_count, baseline, baseline_count) > 0) {
+        status = 1;
+    }
+
+    arena_free(&state.scratch);
+    arena_free(&state.arena);
+    SDL_Quit();
+    return status;
+}
@@ -0,0 +1,94 @@
+#include "capture.h"
+
+#include <stdio.h>
+
+typedef struct {
+    FrameCapture *capture;
+    char path[64];
+    uint32_t width;
+    uint32_t height;
+    SDL_PixelFormat pixel_format;
+    // width * height pixels follow.
+    uint8_t pixels[];
+} CaptureJob;
+
+static int capture_write(void *data) {
+    CaptureJob *job = data;
+    int pitch = (int)(job->width * SDL_BYTESPERPIXEL(job->pixel_format));
+    SDL_Surface *surface =
+        SDL_CreateSurfaceFrom((int)job->width, (int)job->height, job->pixel_format, job->pixels, pitch);
+    if (surface == NULL || !SDL_SaveBMP(surface, job->path))
+        fprintf(stderr, "ERROR: saving %s failed: %s\n", job->path, SDL_GetError());
+    SDL_DestroySurface(surface);
+    SDL_AddAtomicInt(&job->capture->writing, -1);
+    SDL_free(job);
+    return 0;
+}
+
+// Runs on the frame loop, so it only copies the pixels out of the transfer buffer and hands them to a thread.
+static void capture_on_readback(ReadbackHandle handle, const void *data, size_t size, void *user_data) {
+    (void)handle;
+    FrameCapture *capture = user_data;
+
+    CaptureJob *job = SDL_malloc(sizeof(CaptureJob) + size);
+    if (job == NULL)
+        return;
+    job->capture = capture;
+    SDL_snprintf(job->path, sizeof(job->path), "capture_%04u.bmp", capture->count++);
+    job->width = capture->width;
+    job->height = capture->height;
+    job->pixel_format = capture->pixel_format;
+    SDL_memcpy(job->pixels, data, size);
+
+    SDL_AddAtomicInt(&capture->writing, 1);
+    SDL_Thread *thread = SDL_CreateThread(capture_write, "capture", job);
+    if (thread == NULL) {
+        fprintf(stderr, "ERROR: SDL_CreateThread failed: %s\n", SDL_GetError());
+        SDL_AddAtomicInt(&capture->writing, -1);
+        SDL_free(job);
+        return;
+    }
+    SDL_DetachThread(thread);
+}
+
+// Byte order formats, so the surface matches the texture's memory layout on any endianness. sRGB is stored the same.
+static SDL_PixelFormat capture_pixel_format(SDL_GPUTextureFormat format) {
+    switch (format) {
+    case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM_SRGB:
+        return SDL_PIXELFORMAT_BGRA32;
+    case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB:
+        return SDL_PIXELFORMAT_RGBA32;
+    default:
+        return SDL_PIXELFORMAT_UNKNOWN;
+    }
+}
+
+/*
+ * Captures the top left `width` x `height` of `texture` as of the end of this frame. Only one capture is in flight at
+ * a time, returns false if one already is or the format has no matching surface format.
+ */
+bool frame_capture_request(FrameCapture *capture, ReadbackQueue *queue, SDL_GPUDevice *device,
+                           SDL_GPUTexture *texture, SDL_GPUTextureFormat format, uint32_t width, uint32_t height) {
+    if (readback_pending(queue, capture->pending))
+        return false;
+
+    SDL_PixelFormat pixel_format = capture_pixel_format(format);
+    if (pixel_format == SDL_PIXELFORMAT_UNKNOWN) {
+        fprintf(stderr, "ERROR: can't capture texture format %d\n", format);
+        return false;
+    }
+
+    capture->width = width;
+    capture->height = height;
+    capture->pixel_format = pixel_format;
+    capture->pending =
+        readback_texture(queue, device, &(SDL_GPUTextureRegion){.texture = texture, .w = width, .h = height, .d = 1},
+                         format, capture_on_readback, capture);
+    return capture->pending != 0;
+}
+
+bool frame_capture_busy(FrameCapture *capture, const ReadbackQueue *queue) {
+    return readback_pending(queue, capture->pending) || SDL_GetAtomicInt(&capture->writing) > 0;
+}
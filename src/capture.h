@@ -0,0 +1,26 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include "readback.h"
+
+/*
+ * Saves rendered frames as BMP files. The pixels come back through a ReadbackQueue and are written out on a detached
+ * thread, so neither the GPU nor the frame loop waits on the disk.
+ */
+typedef struct {
+    // Numbers the files, capture_0000.bmp, capture_0001.bmp and so on.
+    uint32_t count;
+    // The capture on its way back from the GPU.
+    ReadbackHandle pending;
+    uint32_t width;
+    uint32_t height;
+    SDL_PixelFormat pixel_format;
+    // Captures copied off the GPU whose file isn't written yet.
+    SDL_AtomicInt writing;
+} FrameCapture;
+
+bool frame_capture_request(FrameCapture *capture, ReadbackQueue *queue, SDL_GPUDevice *device,
+                           SDL_GPUTexture *texture, SDL_GPUTextureFormat format, uint32_t width, uint32_t height);
+bool frame_capture_busy(FrameCapture *capture, const ReadbackQueue *queue);
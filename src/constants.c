@@ -5,6 +5,17 @@ const int SCREEN_HEIGHT = 600;
 const int SCREEN_FPS = 60;
 const int SCREEN_TICKS_PER_FRAME = 1000 / SCREEN_FPS;
 
+const int DUNGEON_SIZE = 128;
+const float DUNGEON_TILE_SIZE = 4;
+const float DUNGEON_WALL_HEIGHT = 6;
+
+const int SPRITE_CAPACITY = 65536;
+
+const size_t LEVEL_ARENA_BLOCK_SIZE = 8 * 1024 * 1024;
+const size_t FRAME_ARENA_BLOCK_SIZE = 1024 * 1024;
+
+const int PROFILE_DUMP_SECONDS = 5;
+
 const SDL_FColor COLOR_WHITE = (SDL_FColor){1.0f, 1.0f, 1.0f, 1.0f};
 const SDL_FColor COLOR_BLACK = (SDL_FColor){0.0f, 0.0f, 0.0f, 1.0f};
 const SDL_FColor COLOR_RED = (SDL_FColor){1.0f, 0.0f, 0.0f, 1.0f};
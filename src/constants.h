@@ -7,6 +7,17 @@ const int SCREEN_HEIGHT;
 const int SCREEN_FPS;
 const int SCREEN_TICKS_PER_FRAME;
 
+const int DUNGEON_SIZE;
+const float DUNGEON_TILE_SIZE;
+const float DUNGEON_WALL_HEIGHT;
+
+const int SPRITE_CAPACITY;
+
+const size_t LEVEL_ARENA_BLOCK_SIZE;
+const size_t FRAME_ARENA_BLOCK_SIZE;
+
+const int PROFILE_DUMP_SECONDS;
+
 const SDL_FColor COLOR_WHITE;
 const SDL_FColor COLOR_BLACK;
 const SDL_FColor COLOR_RED;
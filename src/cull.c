@@ -0,0 +1,21 @@
+#include "cull.h"
+
+/*
+ * Only the side planes are kept. The camera's projection has no usable depth range (everything lands on the far
+ * plane) and there is no depth buffer, so near/far culling would either reject everything or nothing.
+ */
+void frustum_from_matrix(Frustum *frustum, mat4 mvp) {
+    vec4 planes[6];
+    glm_frustum_planes(mvp, planes);
+    for (int i = 0; i < 4; i++)
+        glm_vec4_copy(planes[i], frustum->planes[i]);
+}
+
+bool frustum_sphere_visible(const Frustum *frustum, const vec3 center, float radius) {
+    for (int i = 0; i < 4; i++) {
+        const float *plane = frustum->planes[i];
+        if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cglm/cglm.h>
+#include <stdbool.h>
+
+typedef struct {
+    // left, right, bottom, top; normalized, pointing inwards.
+    vec4 planes[4];
+} Frustum;
+
+void frustum_from_matrix(Frustum *frustum, mat4 mvp);
+bool frustum_sphere_visible(const Frustum *frustum, const vec3 center, float radius);
@@ -0,0 +1,340 @@
+#include "dungeon.h"
+#include "constants.h"
+
+#include <SDL3/SDL.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t state;
+} DungeonRng;
+
+typedef struct {
+    int x, y, w, h;
+    // A floor tile inside the region that everything in the region is connected to.
+    int anchor_x, anchor_y;
+} DungeonRegion;
+
+typedef struct {
+    Dungeon *dungeon;
+    const DungeonParams *params;
+    DungeonRegion *regions;
+    int regions_count;
+    SDL_AtomicInt *next_region;
+    // Per worker scratch for caves, region_size^2 entries each.
+    uint8_t *cells;
+    uint8_t *cells_next;
+    int *stack;
+} DungeonWorker;
+
+// splitmix64, good enough for level generation and trivially seedable per region.
+static uint64_t rng_next(DungeonRng *rng) {
+    uint64_t z = (rng->state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static DungeonRng rng_for(uint64_t seed, uint64_t stream) {
+    DungeonRng rng = {seed ^ (stream * 0xd1b54a32d192ed03ull)};
+    rng_next(&rng);
+    return rng;
+}
+
+// Inclusive on both ends.
+static int rng_range(DungeonRng *rng, int lo, int hi) {
+    if (hi <= lo)
+        return lo;
+    return lo + (int)(rng_next(rng) % (uint64_t)(hi - lo + 1));
+}
+
+static float rng_float(DungeonRng *rng) { return (float)(rng_next(rng) >> 40) * (1.0f / 16777216.0f); }
+
+static void carve(Dungeon *dungeon, int x, int y) { dungeon->tiles[y * dungeon->width + x] = TILE_FLOOR; }
+
+static void carve_corridor(Dungeon *dungeon, DungeonRng *rng, int x0, int y0, int x1, int y1) {
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    if (rng_next(rng) & 1) {
+        for (int x = x0; x != x1; x += sx)
+            carve(dungeon, x, y0);
+        for (int y = y0; y != y1; y += sy)
+            carve(dungeon, x1, y);
+    } else {
+        for (int y = y0; y != y1; y += sy)
+            carve(dungeon, x0, y);
+        for (int x = x0; x != x1; x += sx)
+            carve(dungeon, x, y1);
+    }
+    carve(dungeon, x1, y1);
+}
+
+/*
+ * Splits the rectangle until the leaves are about room sized, places a room in every leaf and connects the two halves
+ * of every split with a corridor. Returns a point inside one of the rooms via out_x/out_y.
+ */
+static void bsp_split(Dungeon *dungeon, const DungeonParams *params, DungeonRng *rng, int x, int y, int w, int h,
+                      int *out_x, int *out_y) {
+    const int min_leaf = params->min_room_size + 2;
+    bool can_split_x = w >= 2 * min_leaf;
+    bool can_split_y = h >= 2 * min_leaf;
+    bool small = w < 3 * min_leaf && h < 3 * min_leaf;
+
+    if ((!can_split_x && !can_split_y) || (small && rng_float(rng) < 0.25f)) {
+        int room_w = rng_range(rng, params->min_room_size, w - 2);
+        int room_h = rng_range(rng, params->min_room_size, h - 2);
+        int room_x = rng_range(rng, x + 1, x + w - 1 - room_w);
+        int room_y = rng_range(rng, y + 1, y + h - 1 - room_h);
+        for (int ry = room_y; ry < room_y + room_h; ry++)
+            for (int rx = room_x; rx < room_x + room_w; rx++)
+                carve(dungeon, rx, ry);
+        *out_x = room_x + room_w / 2;
+        *out_y = room_y + room_h / 2;
+        return;
+    }
+
+    bool split_x = can_split_x && (!can_split_y || (w > h ? rng_float(rng) < 0.75f : rng_float(rng) < 0.25f));
+    int ax, ay, bx, by;
+    if (split_x) {
+        int at = rng_range(rng, min_leaf, w - min_leaf);
+        bsp_split(dungeon, params, rng, x, y, at, h, &ax, &ay);
+        bsp_split(dungeon, params, rng, x + at, y, w - at, h, &bx, &by);
+    } else {
+        int at = rng_range(rng, min_leaf, h - min_leaf);
+        bsp_split(dungeon, params, rng, x, y, w, at, &ax, &ay);
+        bsp_split(dungeon, params, rng, x, y + at, w, h - at, &bx, &by);
+    }
+    carve_corridor(dungeon, rng, ax, ay, bx, by);
+
+    if (rng_next(rng) & 1) {
+        *out_x = ax;
+        *out_y = ay;
+    } else {
+        *out_x = bx;
+        *out_y = by;
+    }
+}
+
+static int count_rock_neighbours(const uint8_t *cells, int w, int h, int x, int y) {
+    int count = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx, ny = y + dy;
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h || cells[ny * w + nx])
+                count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * Cellular automata cave. Runs entirely in the worker's scratch buffers, then flood fills from the floor tile closest
+ * to the region centre and only carves what is reachable so the cave is a single connected pocket.
+ */
+static void generate_cave(DungeonWorker *worker, DungeonRegion *region, DungeonRng *rng) {
+    const DungeonParams *params = worker->params;
+    const int w = region->w, h = region->h;
+    uint8_t *cells = worker->cells;
+    uint8_t *next = worker->cells_next;
+
+    // 1 is rock, 0 is open. The outer ring stays rock so caves never touch the neighbouring regions.
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+            cells[y * w + x] = x == 0 || y == 0 || x == w - 1 || y == h - 1 || rng_float(rng) < params->cave_fill;
+
+    for (int i = 0; i < params->cave_iterations; i++) {
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                next[y * w + x] = x == 0 || y == 0 || x == w - 1 || y == h - 1 ||
+                                  count_rock_neighbours(cells, w, h, x, y) >= 5;
+        uint8_t *tmp = cells;
+        cells = next;
+        next = tmp;
+    }
+
+    int best = -1, best_distance = INT32_MAX;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int d = abs(x - w / 2) + abs(y - h / 2);
+            if (!cells[y * w + x] && d < best_distance) {
+                best = y * w + x;
+                best_distance = d;
+            }
+        }
+    }
+    if (best < 0) {
+        // Solid rock, open up a small chamber so the region still links up.
+        for (int y = h / 2 - 1; y <= h / 2 + 1; y++)
+            for (int x = w / 2 - 1; x <= w / 2 + 1; x++)
+                cells[y * w + x] = 0;
+        best = (h / 2) * w + w / 2;
+    }
+
+    // Reuse `next` as the visited mask.
+    memset(next, 0, (size_t)w * h);
+    int top = 0;
+    worker->stack[top++] = best;
+    next[best] = 1;
+    while (top > 0) {
+        int i = worker->stack[--top];
+        int x = i % w, y = i / w;
+        carve(worker->dungeon, region->x + x, region->y + y);
+        const int neighbours[4] = {i - 1, i + 1, i - w, i + w};
+        const bool valid[4] = {x > 0, x < w - 1, y > 0, y < h - 1};
+        for (int n = 0; n < 4; n++) {
+            if (valid[n] && !cells[neighbours[n]] && !next[neighbours[n]]) {
+                next[neighbours[n]] = 1;
+                worker->stack[top++] = neighbours[n];
+            }
+        }
+    }
+
+    region->anchor_x = region->x + best % w;
+    region->anchor_y = region->y + best / w;
+}
+
+static void generate_region(DungeonWorker *worker, int index) {
+    const DungeonParams *params = worker->params;
+    DungeonRegion *region = &worker->regions[index];
+    DungeonRng rng = rng_for(worker->dungeon->seed, (uint64_t)index + 1);
+
+    // Regions too small for a single room (clipped at the map edge) are left as rock.
+    if (region->w < params->min_room_size + 2 || region->h < params->min_room_size + 2) {
+        region->anchor_x = region->x + region->w / 2;
+        region->anchor_y = region->y + region->h / 2;
+        carve(worker->dungeon, region->anchor_x, region->anchor_y);
+        return;
+    }
+
+    if (rng_float(&rng) < params->cave_chance) {
+        generate_cave(worker, region, &rng);
+    } else {
+        bsp_split(worker->dungeon, params, &rng, region->x, region->y, region->w, region->h, &region->anchor_x,
+                  &region->anchor_y);
+    }
+}
+
+static int dungeon_worker(void *data) {
+    DungeonWorker *worker = data;
+    for (;;) {
+        int index = SDL_AddAtomicInt(worker->next_region, 1);
+        if (index >= worker->regions_count)
+            break;
+        generate_region(worker, index);
+    }
+    return 0;
+}
+
+void dungeon_default_params(DungeonParams *params, int width, int height) {
+    *params = (DungeonParams){
+        .width = width,
+        .height = height,
+        .region_size = 64,
+        .min_room_size = 4,
+        .cave_chance = 0.3f,
+        .cave_fill = 0.45f,
+        .cave_iterations = 4,
+        .num_threads = 0,
+    };
+}
+
+// The tiles are allocated from `arena` and live as long as it does, scratch memory is given back before returning.
+void dungeon_generate(Dungeon *dungeon, Arena *arena, uint64_t seed, const DungeonParams *params) {
+    assert(params->width > 0 && params->height > 0);
+    assert(params->region_size >= params->min_room_size + 2);
+
+    dungeon->seed = seed;
+    dungeon->width = params->width;
+    dungeon->height = params->height;
+    dungeon->tiles = arena_alloc_zero(arena, (size_t)params->width * params->height);
+    ArenaMark scratch_mark = arena_mark(arena);
+
+    const int rs = params->region_size;
+    const int regions_x = (params->width + rs - 1) / rs;
+    const int regions_y = (params->height + rs - 1) / rs;
+    const int regions_count = regions_x * regions_y;
+
+    DungeonRegion *regions = arena_push_array(arena, DungeonRegion, regions_count);
+    for (int ry = 0; ry < regions_y; ry++) {
+        for (int rx = 0; rx < regions_x; rx++) {
+            DungeonRegion *region = &regions[ry * regions_x + rx];
+            region->x = rx * rs;
+            region->y = ry * rs;
+            region->w = SDL_min(rs, params->width - region->x);
+            region->h = SDL_min(rs, params->height - region->y);
+        }
+    }
+
+    int num_threads = params->num_threads > 0 ? params->num_threads : SDL_GetNumLogicalCPUCores();
+    num_threads = SDL_clamp(num_threads, 1, regions_count);
+
+    // Regions only ever write inside their own bounds and draw from their own rng stream, so the result is the same
+    // no matter which thread picks up which region.
+    SDL_AtomicInt next_region = {0};
+    const size_t cells_count = (size_t)rs * rs;
+    DungeonWorker *workers = arena_push_array(arena, DungeonWorker, num_threads);
+    uint8_t *cells = arena_push_array(arena, uint8_t, num_threads * cells_count * 2);
+    int *stack = arena_push_array(arena, int, num_threads * cells_count);
+
+    for (int i = 0; i < num_threads; i++) {
+        workers[i] = (DungeonWorker){
+            .dungeon = dungeon,
+            .params = params,
+            .regions = regions,
+            .regions_count = regions_count,
+            .next_region = &next_region,
+            .cells = cells + 2 * i * cells_count,
+            .cells_next = cells + (2 * i + 1) * cells_count,
+            .stack = stack + i * cells_count,
+        };
+    }
+
+    SDL_Thread **threads = arena_push_array(arena, SDL_Thread *, num_threads);
+    for (int i = 1; i < num_threads; i++) {
+        threads[i] = SDL_CreateThread(dungeon_worker, "dungeon", &workers[i]);
+        CHECK(threads[i]);
+    }
+    dungeon_worker(&workers[0]);
+    for (int i = 1; i < num_threads; i++)
+        SDL_WaitThread(threads[i], NULL);
+
+    // Link every region to its right and lower neighbour. Serial, so the order is fixed.
+    for (int ry = 0; ry < regions_y; ry++) {
+        for (int rx = 0; rx < regions_x; rx++) {
+            DungeonRegion *region = &regions[ry * regions_x + rx];
+            DungeonRng rng = rng_for(seed, (uint64_t)regions_count + 1 + ry * regions_x + rx);
+            if (rx + 1 < regions_x) {
+                DungeonRegion *right = &regions[ry * regions_x + rx + 1];
+                carve_corridor(dungeon, &rng, region->anchor_x, region->anchor_y, right->anchor_x, right->anchor_y);
+            }
+            if (ry + 1 < regions_y) {
+                DungeonRegion *below = &regions[(ry + 1) * regions_x + rx];
+                carve_corridor(dungeon, &rng, region->anchor_x, region->anchor_y, below->anchor_x, below->anchor_y);
+            }
+        }
+    }
+
+    // Any rock touching floor becomes a wall.
+    for (int y = 0; y < dungeon->height; y++) {
+        for (int x = 0; x < dungeon->width; x++) {
+            uint8_t *tile = &dungeon->tiles[y * dungeon->width + x];
+            if (*tile != TILE_EMPTY)
+                continue;
+            for (int dy = -1; dy <= 1 && *tile == TILE_EMPTY; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (dungeon_tile(dungeon, x + dx, y + dy) == TILE_FLOOR) {
+                        *tile = TILE_WALL;
+                        break;
+                    }
+        }
+    }
+
+    arena_rewind(arena, scratch_mark);
+}
+
+TileType dungeon_tile(const Dungeon *dungeon, int x, int y) {
+    if (x < 0 || y < 0 || x >= dungeon->width || y >= dungeon->height)
+        return TILE_EMPTY;
+    return dungeon->tiles[y * dungeon->width + x];
+}
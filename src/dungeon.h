@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "arena.h"
+
+typedef enum { TILE_EMPTY, TILE_FLOOR, TILE_WALL } TileType;
+
+typedef struct {
+    int width;
+    int height;
+    // The map is cut into square regions of this size which are generated independently (and in parallel).
+    int region_size;
+    int min_room_size;
+    // Chance for a region to be a cellular automata cave instead of BSP rooms.
+    float cave_chance;
+    float cave_fill;
+    int cave_iterations;
+    // 0 uses one thread per logical core. The output does not depend on this.
+    int num_threads;
+} DungeonParams;
+
+typedef struct {
+    uint64_t seed;
+    int width;
+    int height;
+    uint8_t *tiles;
+} Dungeon;
+
+void dungeon_default_params(DungeonParams *params, int width, int height);
+void dungeon_generate(Dungeon *dungeon, Arena *arena, uint64_t seed, const DungeonParams *params);
+TileType dungeon_tile(const Dungeon *dungeon, int x, int y);
@@ -0,0 +1,86 @@
+#include "dynamic_resolution.h"
+#include "constants.h"
+#include <math.h>
+
+void dynamic_resolution_init(DynamicResolution *dynres, SDL_GPUTextureFormat format, SDL_GPUDevice *device,
+                             uint32_t width, uint32_t height) {
+    *dynres = (DynamicResolution){
+        .max_width = width,
+        .max_height = height,
+        .width = width,
+        .height = height,
+        .enabled = true,
+        .scale = 1.0f,
+        .min_scale = 0.5f,
+        .budget_ms = 1000.0f / SCREEN_FPS,
+    };
+
+    dynres->texture =
+        SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+                                         .type = SDL_GPU_TEXTURETYPE_2D,
+                                         .format = format,
+                                         .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+                                         .width = width,
+                                         .height = height,
+                                         .layer_count_or_depth = 1,
+                                         .num_levels = 1,
+                                     });
+    CHECK(dynres->texture);
+}
+
+/*
+ * GPU time scales roughly with the pixel count, i.e. with scale^2, so the scale that would just fit the budget is
+ * scale * sqrt(budget / gpu_ms). Nothing changes while the frame time is within 85-100% of the budget and the scale
+ * only moves part of the way there each frame, which keeps it from oscillating.
+ */
+void dynamic_resolution_update(DynamicResolution *dynres, float gpu_ms) {
+    if (!dynres->enabled) {
+        dynres->scale = 1.0f;
+    } else if (gpu_ms > 0 && (gpu_ms > dynres->budget_ms || gpu_ms < dynres->budget_ms * 0.85f)) {
+        float target = dynres->scale * sqrtf(dynres->budget_ms / gpu_ms);
+        target = SDL_clamp(target, dynres->min_scale, 1.0f);
+        dynres->scale += (target - dynres->scale) * 0.1f;
+    }
+    dynres->scale = SDL_clamp(dynres->scale, dynres->min_scale, 1.0f);
+
+    dynres->width = SDL_max(1, (uint32_t)lroundf(dynres->max_width * dynres->scale));
+    dynres->height = SDL_max(1, (uint32_t)lroundf(dynres->max_height * dynres->scale));
+}
+
+SDL_GPURenderPass *dynamic_resolution_begin_scene(DynamicResolution *dynres, SDL_GPUCommandBuffer *cmdbuf,
+                                                  SDL_FColor clear_color) {
+    SDL_GPUColorTargetInfo color_target_info = {0};
+    color_target_info.texture = dynres->texture;
+    color_target_info.clear_color = clear_color;
+    color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
+    color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+
+    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(cmdbuf, &color_target_info, 1, NULL);
+    CHECK(render_pass);
+
+    SDL_SetGPUViewport(render_pass, &(SDL_GPUViewport){
+                                        .x = 0,
+                                        .y = 0,
+                                        .w = (float)dynres->width,
+                                        .h = (float)dynres->height,
+                                        .min_depth = 0,
+                                        .max_depth = 1,
+                                    });
+    SDL_SetGPUScissor(render_pass, &(SDL_Rect){0, 0, (int)dynres->width, (int)dynres->height});
+    return render_pass;
+}
+
+void dynamic_resolution_blit(DynamicResolution *dynres, SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *target,
+                             uint32_t target_width, uint32_t target_height) {
+    SDL_BlitGPUTexture(cmdbuf, &(SDL_GPUBlitInfo){
+                                   .source = {.texture = dynres->texture, .w = dynres->width, .h = dynres->height},
+                                   .destination = {.texture = target, .w = target_width, .h = target_height},
+                                   .load_op = SDL_GPU_LOADOP_DONT_CARE,
+                                   .filter = SDL_GPU_FILTER_LINEAR,
+                               });
+}
+
+void dynamic_resolution_release(DynamicResolution *dynres, SDL_GPUDevice *device) {
+    SDL_ReleaseGPUTexture(device, dynres->texture);
+    *dynres = (DynamicResolution){0};
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+/*
+ * Offscreen scene target whose rendered area shrinks and grows with the measured GPU frame time. The texture is
+ * allocated once at full size and only its top left `width` x `height` is rendered to, so changing the scale never
+ * reallocates. The result is upscaled into the swapchain with a filtered blit.
+ */
+typedef struct {
+    SDL_GPUTexture *texture;
+    uint32_t max_width;
+    uint32_t max_height;
+    uint32_t width;
+    uint32_t height;
+
+    bool enabled;
+    float scale;
+    float min_scale;
+    float budget_ms;
+} DynamicResolution;
+
+void dynamic_resolution_init(DynamicResolution *dynres, SDL_GPUTextureFormat format, SDL_GPUDevice *device,
+                             uint32_t width, uint32_t height);
+void dynamic_resolution_update(DynamicResolution *dynres, float gpu_ms);
+SDL_GPURenderPass *dynamic_resolution_begin_scene(DynamicResolution *dynres, SDL_GPUCommandBuffer *cmdbuf,
+                                                  SDL_FColor clear_color);
+void dynamic_resolution_blit(DynamicResolution *dynres, SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *target,
+                             uint32_t target_width, uint32_t target_height);
+void dynamic_resolution_release(DynamicResolution *dynres, SDL_GPUDevice *device);
@@ -0,0 +1,69 @@
+#include "frame_timer.h"
+
+/*
+ * Submits `cmdbuf` in place of SDL_SubmitGPUCommandBuffer and starts tracking it. `input_ns` is the SDL event
+ * timestamp of the oldest input handled this frame, or 0.
+ */
+bool frame_timer_submit(FrameTimer *timer, SDL_GPUDevice *device, SDL_GPUCommandBuffer *cmdbuf, uint64_t input_ns) {
+    SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdbuf);
+    if (fence == NULL)
+        return false;
+
+    // Only happens if the GPU is more than FRAME_TIMER_MAX_IN_FLIGHT frames behind, that frame goes unmeasured.
+    if (timer->count == FRAME_TIMER_MAX_IN_FLIGHT) {
+        SDL_ReleaseGPUFence(device, timer->entries[timer->head].fence);
+        timer->head = (timer->head + 1) % FRAME_TIMER_MAX_IN_FLIGHT;
+        timer->count--;
+    }
+
+    FrameTimerEntry *entry = &timer->entries[(timer->head + timer->count) % FRAME_TIMER_MAX_IN_FLIGHT];
+    entry->fence = fence;
+    entry->submit_ns = SDL_GetTicksNS();
+    entry->input_ns = input_ns;
+    timer->count++;
+    return true;
+}
+
+void frame_timer_poll(FrameTimer *timer, SDL_GPUDevice *device) {
+    while (timer->count > 0) {
+        FrameTimerEntry *entry = &timer->entries[timer->head];
+        if (!SDL_QueryGPUFence(device, entry->fence))
+            break;
+
+        uint64_t now = SDL_GetTicksNS();
+        uint64_t start = SDL_max(entry->submit_ns, timer->last_complete_ns);
+        float ms = (now - start) / 1e6f;
+        timer->gpu_ms = timer->gpu_ms == 0 ? ms : timer->gpu_ms * 0.9f + ms * 0.1f;
+        timer->last_complete_ns = now;
+
+        if (entry->input_ns) {
+            timer->input_to_submit_ms[timer->latency_head] = (entry->submit_ns - entry->input_ns) / 1e6f;
+            timer->input_to_gpu_ms[timer->latency_head] = (now - entry->input_ns) / 1e6f;
+            timer->latency_head = (timer->latency_head + 1) % FRAME_TIMER_HISTORY;
+            timer->latency_count = SDL_min(timer->latency_count + 1, FRAME_TIMER_HISTORY);
+        }
+
+        SDL_ReleaseGPUFence(device, entry->fence);
+        timer->head = (timer->head + 1) % FRAME_TIMER_MAX_IN_FLIGHT;
+        timer->count--;
+    }
+}
+
+void frame_timer_release(FrameTimer *timer, SDL_GPUDevice *device) {
+    for (size_t i = 0; i < timer->count; i++)
+        SDL_ReleaseGPUFence(device, timer->entries[(timer->head + i) % FRAME_TIMER_MAX_IN_FLIGHT].fence);
+    *timer = (FrameTimer){0};
+}
+
+// `history` is one of the timer's latency rings.
+LatencyStats frame_timer_latency_stats(const FrameTimer *timer, const float *history) {
+    LatencyStats stats = {0};
+    if (timer->latency_count == 0)
+        return stats;
+    for (size_t i = 0; i < timer->latency_count; i++) {
+        stats.average_ms += history[i];
+        stats.max_ms = SDL_max(stats.max_ms, history[i]);
+    }
+    stats.average_ms /= timer->latency_count;
+    return stats;
+}
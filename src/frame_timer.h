@@ -0,0 +1,48 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#define FRAME_TIMER_MAX_IN_FLIGHT 8
+#define FRAME_TIMER_HISTORY 120
+
+typedef struct {
+    SDL_GPUFence *fence;
+    uint64_t submit_ns;
+    // Timestamp of the oldest input event the frame responds to, 0 if there was none.
+    uint64_t input_ns;
+} FrameTimerEntry;
+
+/*
+ * SDL_gpu has no timestamp queries, so GPU time is estimated from fences: a frame's GPU time is from when the GPU
+ * could start on it (its submit, or the previous frame finishing if that was later) to when its fence is seen
+ * signalled. Poll as often as possible, the estimate is only as fine as the polling.
+ *
+ * Frames that respond to input also record input to submit and input to GPU completion latency. There is no present
+ * timestamp either, so the GPU finishing is the closest stand-in for the photons; the real present still waits for
+ * the next vblank with VSync.
+ */
+typedef struct {
+    FrameTimerEntry entries[FRAME_TIMER_MAX_IN_FLIGHT];
+    size_t head;
+    size_t count;
+    uint64_t last_complete_ns;
+    // Exponential moving average of the GPU time in milliseconds.
+    float gpu_ms;
+
+    // Ring of the last FRAME_TIMER_HISTORY latency samples in milliseconds.
+    float input_to_submit_ms[FRAME_TIMER_HISTORY];
+    float input_to_gpu_ms[FRAME_TIMER_HISTORY];
+    size_t latency_head;
+    size_t latency_count;
+} FrameTimer;
+
+typedef struct {
+    float average_ms;
+    float max_ms;
+} LatencyStats;
+
+bool frame_timer_submit(FrameTimer *timer, SDL_GPUDevice *device, SDL_GPUCommandBuffer *cmdbuf, uint64_t input_ns);
+void frame_timer_poll(FrameTimer *timer, SDL_GPUDevice *device);
+void frame_timer_release(FrameTimer *timer, SDL_GPUDevice *device);
+LatencyStats frame_timer_latency_stats(const FrameTimer *timer, const float *history);
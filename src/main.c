@@ -1,6 +1,7 @@
 #include "SDL3/SDL_gpu.h"
 #include "SDL3/SDL_scancode.h"
 #include <assert.h>
+#include <float.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,11 +14,182 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_video.h>
 
+#include "arena.h"
 #include "camera.h"
+#include "capture.h"
 #include "constants.h"
+#include "dungeon.h"
+#include "dynamic_resolution.h"
+#include "frame_timer.h"
+#include "mesh.h"
+#include "picking.h"
 #include "pipeline.h"
+#include "profiler.h"
+#include "readback.h"
+#include "sprite_batch.h"
+#include "swapchain.h"
+#include "texture.h"
+
+// Dungeon triangles are picked as PICK_ID_DUNGEON + triangle index.
+enum { PICK_ID_NONE, PICK_ID_CUBE, PICK_ID_DUNGEON };
+
+// Everything that lives as long as the current dungeon. The CPU side is allocated from the level arena.
+typedef struct {
+    Dungeon dungeon;
+    Pipeline pipeline;
+    // Tile of every mesh triangle, in draw order.
+    uint32_t *triangle_tiles;
+    size_t triangles_count;
+    uint64_t generate_ns;
+    MeshOptimizeStats mesh_stats;
+} Level;
+
+/*
+ * (Re)generates the dungeon and its mesh. Everything the level allocates on the CPU comes from `level_arena`, which
+ * is reset when the previous level is unloaded.
+ */
+static void level_load(Level *level, Arena *level_arena, uint64_t seed, const DungeonParams *params,
+                       const TextureArray *tile_textures, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device) {
+    if (level->dungeon.tiles) {
+        pipeline_release(&level->pipeline, device);
+        arena_reset(level_arena);
+    }
+
+    PROFILE_BEGIN("level_load");
+    uint64_t start = SDL_GetTicksNS();
+    PROFILE_BEGIN("dungeon_generate");
+    dungeon_generate(&level->dungeon, level_arena, seed, params);
+    PROFILE_END("dungeon_generate");
+    level->generate_ns = SDL_GetTicksNS() - start;
+
+    level->triangles_count = mesh_dungeon_triangles_count(&level->dungeon);
+    level->triangle_tiles = arena_push_array(level_arena, uint32_t, level->triangles_count);
+
+    // The mesh is only needed until it's uploaded.
+    ArenaMark mark = arena_mark(level_arena);
+    Mesh mesh;
+    PROFILE_BEGIN("mesh_build_dungeon");
+    mesh_build_dungeon(&mesh, level_arena, &level->dungeon, DUNGEON_TILE_SIZE, DUNGEON_WALL_HEIGHT);
+    PROFILE_END("mesh_build_dungeon");
+    // No overdraw clustering, without a depth test the draw order is what decides visibility.
+    PROFILE_BEGIN("mesh_optimize");
+    mesh_optimize(&mesh, level_arena, false, &level->mesh_stats);
+    PROFILE_END("mesh_optimize");
+    mesh_dungeon_triangle_tiles(&mesh, &level->dungeon, DUNGEON_TILE_SIZE, level->triangle_tiles);
+    mesh_pipeline_init(&level->pipeline, color_format, device, &mesh, tile_textures);
+    arena_rewind(level_arena, mark);
+    PROFILE_END("level_load");
+}
+
+// Placeholder tile art until there are real images, one texture array layer per TileLayer.
+static void create_tile_textures(TextureArray *textures, SDL_GPUDevice *device) {
+    enum { SIZE = 64 };
+    static uint8_t pixels[TILE_LAYER_COUNT][SIZE * SIZE * 4];
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            uint32_t noise = ((uint32_t)(x * 73856093) ^ (uint32_t)(y * 19349663)) % 24;
+
+            // Floor: four big slabs.
+            bool seam = x % 32 == 0 || y % 32 == 0;
+            uint8_t slab = seam ? 60 : 120 + noise;
+            // Wall side: offset brick rows.
+            int brick_x = (x + (y / 16 % 2) * 16) % 32;
+            bool mortar = y % 16 == 0 || brick_x == 0;
+            uint8_t brick = mortar ? 90 : 140 + noise;
+            // Wall top: rough dark stone.
+            uint8_t top = 80 + noise * 2;
+
+            const uint8_t colors[TILE_LAYER_COUNT][3] = {
+                [TILE_LAYER_FLOOR] = {slab, slab, slab * 9 / 10},
+                [TILE_LAYER_WALL_TOP] = {top, top * 9 / 10, top * 8 / 10},
+                [TILE_LAYER_WALL_SIDE] = {brick, brick * 7 / 10, brick * 5 / 10},
+            };
+            for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+                uint8_t *pixel = &pixels[layer][(y * SIZE + x) * 4];
+                pixel[0] = colors[layer][0];
+                pixel[1] = colors[layer][1];
+                pixel[2] = colors[layer][2];
+                pixel[3] = 255;
+            }
+        }
+    }
+    texture_array_init(textures, device, SIZE, SIZE, TILE_LAYER_COUNT, pixels);
+}
+
+// Soft round blob, the placeholder sprite until there is sprite art.
+static void pack_particle(TextureAtlas *atlas, vec4 uv) {
+    enum { SIZE = 32 };
+    static uint8_t pixels[SIZE * SIZE * 4];
+    for (int y = 0; y < SIZE; y++) {
+        for (int x = 0; x < SIZE; x++) {
+            float dx = (x + 0.5f) / SIZE * 2 - 1, dy = (y + 0.5f) / SIZE * 2 - 1;
+            float alpha = glm_clamp(1.0f - sqrtf(dx * dx + dy * dy), 0.0f, 1.0f);
+            uint8_t *pixel = &pixels[(y * SIZE + x) * 4];
+            pixel[0] = pixel[1] = pixel[2] = 255;
+            pixel[3] = (uint8_t)(alpha * 255);
+        }
+    }
+    CHECK(texture_atlas_pack(atlas, SIZE, SIZE, pixels, uv));
+}
+
+static const char *PRESENT_MODE_NAMES[] = {
+    [SDL_GPU_PRESENTMODE_VSYNC] = "VSync",
+    [SDL_GPU_PRESENTMODE_IMMEDIATE] = "Immediate",
+    [SDL_GPU_PRESENTMODE_MAILBOX] = "Mailbox",
+};
+
+static const char *COMPOSITION_NAMES[] = {
+    [SDL_GPU_SWAPCHAINCOMPOSITION_SDR] = "SDR",
+    [SDL_GPU_SWAPCHAINCOMPOSITION_SDR_LINEAR] = "SDR Linear",
+    [SDL_GPU_SWAPCHAINCOMPOSITION_HDR_EXTENDED_LINEAR] = "HDR Extended Linear",
+    [SDL_GPU_SWAPCHAINCOMPOSITION_HDR10_ST2084] = "HDR10 ST2084",
+};
+
+static bool is_input_event(Uint32 type) {
+    switch (type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+    case SDL_EVENT_MOUSE_MOTION:
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+    case SDL_EVENT_MOUSE_WHEEL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Writes the last PROFILE_DUMP_SECONDS of zones to trace_NNNN.json.
+static void dump_trace(uint32_t *traces_count) {
+    char path[32];
+    SDL_snprintf(path, sizeof(path), "trace_%04u.json", (*traces_count)++);
+    if (profile_dump(path, (uint64_t)PROFILE_DUMP_SECONDS * 1000000000))
+        fprintf(stdout, "Wrote %s\n", path);
+}
+
+static void *imgui_alloc(size_t size, void *user_data) {
+    (void)user_data;
+    return heap_alloc(size);
+}
+
+static void imgui_free(void *ptr, void *user_data) {
+    (void)user_data;
+    heap_free(ptr);
+}
+
+static void imgui_gpu_init(SDL_GPUDevice *device, SDL_Window *window) {
+    CHECK(ImGui_ImplSDLGPU3_Init(&(ImGui_ImplSDLGPU3_InitInfo){
+        .ColorTargetFormat = SDL_GetGPUSwapchainTextureFormat(device, window),
+        .Device = device,
+        .MSAASamples = SDL_GPU_SAMPLECOUNT_1,
+    }));
+}
 
 int main() {
+    heap_track_sdl_allocations();
+    PROFILE_THREAD("main");
+    PROFILE_BEGIN("startup");
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         fprintf(stderr, "Failed to init video! %s", SDL_GetError());
         return 1;
@@ -36,6 +208,7 @@ int main() {
     CHECK(SDL_ClaimWindowForGPUDevice(device, window));
 
     // setup imgui
+    igSetAllocatorFunctions(imgui_alloc, imgui_free, NULL);
     igCreateContext(NULL);
 
     // set docking
@@ -47,21 +220,57 @@ int main() {
     ioptr->ConfigFlags |= ImGuiConfigFlags_ViewportsEnable; // Enable Multi-Viewport / Platform Windows
 #endif
 
+    SwapchainSettings swapchain_settings;
+    swapchain_settings_default(&swapchain_settings);
+    CHECK(swapchain_settings_apply(&swapchain_settings, NULL, device, window));
+
     assert(ImGui_ImplSDL3_InitForSDLGPU(window));
-    assert(ImGui_ImplSDLGPU3_Init(&(ImGui_ImplSDLGPU3_InitInfo){
-        .ColorTargetFormat = SDL_GetGPUSwapchainTextureFormat(device, window),
-        .Device = device,
-        .MSAASamples = SDL_GPU_SAMPLECOUNT_1,
-    }));
+    imgui_gpu_init(device, window);
+
+    // The scene is drawn offscreen, so its format stays put when the swapchain composition changes.
+    const SDL_GPUTextureFormat scene_format = SDL_GetGPUSwapchainTextureFormat(device, window);
+
+    Arena level_arena;
+    arena_init(&level_arena, LEVEL_ARENA_BLOCK_SIZE);
+    Arena frame_arena;
+    arena_init(&frame_arena, FRAME_ARENA_BLOCK_SIZE);
 
     Pipeline cube_pipeline;
-    cube_pipeline_init(&cube_pipeline, window, device);
+    cube_pipeline_init(&cube_pipeline, scene_format, device);
 
     Pipeline floor_tile_pipeline;
-    floor_tile_pipeline_init(&floor_tile_pipeline, window, device);
+    floor_tile_pipeline_init(&floor_tile_pipeline, scene_format, device, &frame_arena);
+
+    TextureArray tile_textures;
+    create_tile_textures(&tile_textures, device);
+
+    uint64_t dungeon_seed = 1;
+    DungeonParams dungeon_params;
+    dungeon_default_params(&dungeon_params, DUNGEON_SIZE, DUNGEON_SIZE);
+    Level level = {0};
+    level_load(&level, &level_arena, dungeon_seed, &dungeon_params, &tile_textures, scene_format, device);
+
+    SpriteBatch sprite_batch;
+    sprite_batch_init(&sprite_batch, scene_format, device, SPRITE_CAPACITY);
+    TextureAtlas sprite_atlas;
+    texture_atlas_init(&sprite_atlas, 256, 256);
+    vec4 particle_uv;
+    pack_particle(&sprite_atlas, particle_uv);
+    texture_atlas_upload(&sprite_atlas, device);
+    uint32_t particle_page = sprite_batch_add_page(&sprite_batch, sprite_atlas.texture);
+
+    DynamicResolution dynres;
+    dynamic_resolution_init(&dynres, scene_format, device, SCREEN_WIDTH, SCREEN_HEIGHT);
+    FrameTimer frame_timer = {0};
+    ReadbackQueue readback_queue = {0};
+    Picker picker;
+    picker_init(&picker, device);
+    FrameCapture capture = {0};
 
     // finish loading data
 
+    PROFILE_END("startup");
+
     Camera camera = {0};
     camera_init(&camera);
     bool running = true;
@@ -71,6 +280,21 @@ int main() {
     bool demo_window_open = true;
     bool show_cube = true;
     bool show_tiles = true;
+    bool show_dungeon = true;
+    bool show_sprites = true;
+    int sprites_count = 10000;
+    bool cap_frame_rate = true;
+    bool picking = true;
+    bool capture_requested = false;
+    // Oldest input event not yet answered by a submitted frame.
+    uint64_t pending_input_ns = 0;
+    uint32_t heap_allocations_seen = heap_allocations_count();
+    uint32_t frame_heap_allocations = 0;
+    uint32_t traces_count = 0;
+    bool dump_on_hitch = false;
+    float hitch_ms = 50.0f;
+    // 0 right after a dump, so the dump's own hitch doesn't trigger another one.
+    uint64_t last_frame_start_ns = 0;
 
     while (running) {
 
@@ -96,6 +320,8 @@ int main() {
 
         while (SDL_PollEvent(&e)) {
             ImGui_ImplSDL3_ProcessEvent(&e);
+            if (is_input_event(e.type) && pending_input_ns == 0)
+                pending_input_ns = e.common.timestamp;
             switch (e.type) {
             case SDL_EVENT_KEY_DOWN: {
                 switch (e.key.scancode) {
@@ -103,6 +329,11 @@ int main() {
                     running = false;
                 } break;
 
+                case SDL_SCANCODE_F9: {
+                    dump_trace(&traces_count);
+                    last_frame_start_ns = 0;
+                } break;
+
                 default:
                     continue;
                 }
@@ -113,11 +344,33 @@ int main() {
             }
         }
 
+        // Polled every iteration rather than every frame, it's what the GPU time resolution depends on.
+        frame_timer_poll(&frame_timer, device);
+        readback_queue_poll(&readback_queue, device);
+
         previous = now;
         now = SDL_GetTicks();
-        if (now - last_frame_time >= SCREEN_TICKS_PER_FRAME) {
+        if (!cap_frame_rate || now - last_frame_time >= SCREEN_TICKS_PER_FRAME) {
             last_frame_time = now;
 
+            uint64_t frame_start_ns = SDL_GetTicksNS();
+            if (dump_on_hitch && last_frame_start_ns && frame_start_ns - last_frame_start_ns > hitch_ms * 1e6) {
+                dump_trace(&traces_count);
+                frame_start_ns = 0;
+            }
+            last_frame_start_ns = frame_start_ns;
+            PROFILE_BEGIN("frame");
+
+            // Everything since the previous frame started, the whole loop should be allocation free.
+            uint32_t heap_allocations = heap_allocations_count();
+            frame_heap_allocations = heap_allocations - heap_allocations_seen;
+            heap_allocations_seen = heap_allocations;
+            arena_reset(&frame_arena);
+
+            dynamic_resolution_update(&dynres, frame_timer.gpu_ms);
+
+            PROFILE_BEGIN("ui");
+
             ImGui_ImplSDLGPU3_NewFrame();
             ImGui_ImplSDL3_NewFrame();
             igNewFrame();
@@ -126,11 +379,117 @@ int main() {
                 igBegin("Debug", &demo_window_open, 0);
                 igCheckbox("Show Cube", &show_cube);
                 igCheckbox("Show Tiles", &show_tiles);
+                igCheckbox("Show Dungeon", &show_dungeon);
+                igInputScalar("Seed", ImGuiDataType_U64, &dungeon_seed, NULL, NULL, NULL, 0);
+                if (igButton("Regenerate", (ImVec2){0, 0})) {
+                    level_load(&level, &level_arena, dungeon_seed, &dungeon_params, &tile_textures, scene_format,
+                               device);
+                }
+                igText("Generated in %.2f ms", level.generate_ns / 1e6);
+                igText("Mesh: %zu -> %zu vertices", level.mesh_stats.vertices_before, level.mesh_stats.vertices_after);
+                igText("ACMR: %.3f unwelded, %.3f welded, %.3f reordered", level.mesh_stats.acmr_unwelded,
+                       level.mesh_stats.acmr_before, level.mesh_stats.acmr_after);
+                igText("Level arena: %.1f MB used, %.1f MB peak, %zu blocks", level_arena.used / 1048576.0,
+                       level_arena.peak / 1048576.0, level_arena.blocks_count);
+                igText("Frame arena: %.1f KB peak, %zu blocks", frame_arena.peak / 1024.0, frame_arena.blocks_count);
+                igText("Heap allocations last frame: %u", frame_heap_allocations);
+                igCheckbox("Picking", &picking);
+                uint32_t hovered = picking ? picker.hovered_id : PICK_ID_NONE;
+                if (hovered == PICK_ID_CUBE) {
+                    igText("Hovered: cube");
+                } else if (hovered >= PICK_ID_DUNGEON && hovered - PICK_ID_DUNGEON < level.triangles_count) {
+                    int tile = (int)level.triangle_tiles[hovered - PICK_ID_DUNGEON];
+                    int x = tile % level.dungeon.width, y = tile / level.dungeon.width;
+                    igText("Hovered: %s tile (%d, %d)",
+                           dungeon_tile(&level.dungeon, x, y) == TILE_WALL ? "wall" : "floor", x, y);
+                } else {
+                    igText("Hovered: nothing");
+                }
+                if (igButton("Capture Frame", (ImVec2){0, 0}))
+                    capture_requested = true;
+                igSameLine(0, -1);
+                if (frame_capture_busy(&capture, &readback_queue))
+                    igText("Saving...");
+                else
+                    igText("%u saved", capture.count);
+                igText("Readbacks in flight: %zu", readback_queue.in_flight_count);
+                if (igButton("Dump Trace (F9)", (ImVec2){0, 0})) {
+                    dump_trace(&traces_count);
+                    last_frame_start_ns = 0;
+                }
+                igCheckbox("Dump On Hitch", &dump_on_hitch);
+                igSliderFloat("Hitch (ms)", &hitch_ms, 17.0f, 200.0f, "%.0f", 0);
+                igCheckbox("Show Sprites", &show_sprites);
+                igSliderInt("Sprites", &sprites_count, 0, SPRITE_CAPACITY, "%d", 0);
+                igCheckbox("Dynamic Resolution", &dynres.enabled);
+                igSliderFloat("Min Scale", &dynres.min_scale, 0.25f, 1.0f, "%.2f", 0);
+                igSliderFloat("GPU Budget (ms)", &dynres.budget_ms, 1.0f, 33.0f, "%.1f", 0);
+                igText("GPU %.2f ms, %ux%u (%.0f%%)", frame_timer.gpu_ms, dynres.width, dynres.height,
+                       dynres.scale * 100);
+
+                SwapchainSettings previous_settings = swapchain_settings;
+                int frames_in_flight = swapchain_settings.frames_in_flight;
+                int present_mode = swapchain_settings.present_mode;
+                int composition = swapchain_settings.composition;
+                bool changed = igSliderInt("Frames In Flight", &frames_in_flight, 1, 3, "%d", 0);
+                changed |= igCombo_Str_arr("Present Mode", &present_mode, PRESENT_MODE_NAMES,
+                                           SDL_arraysize(PRESENT_MODE_NAMES), -1);
+                changed |= igCombo_Str_arr("Composition", &composition, COMPOSITION_NAMES,
+                                           SDL_arraysize(COMPOSITION_NAMES), -1);
+                igCheckbox("Wait For Swapchain", &swapchain_settings.wait_for_swapchain);
+                igCheckbox("Cap Frame Rate", &cap_frame_rate);
+                if (changed) {
+                    swapchain_settings.frames_in_flight = frames_in_flight;
+                    swapchain_settings.present_mode = present_mode;
+                    swapchain_settings.composition = composition;
+
+                    SDL_GPUTextureFormat old_format = SDL_GetGPUSwapchainTextureFormat(device, window);
+                    if (!swapchain_settings_apply(&swapchain_settings, &previous_settings, device, window)) {
+                        swapchain_settings = previous_settings;
+                    } else if (SDL_GetGPUSwapchainTextureFormat(device, window) != old_format) {
+                        // ImGui's pipeline targets the swapchain directly and has to follow its format.
+                        SDL_WaitForGPUIdle(device);
+                        ImGui_ImplSDLGPU3_Shutdown();
+                        imgui_gpu_init(device, window);
+                    }
+                }
+
+                LatencyStats to_submit = frame_timer_latency_stats(&frame_timer, frame_timer.input_to_submit_ms);
+                LatencyStats to_gpu = frame_timer_latency_stats(&frame_timer, frame_timer.input_to_gpu_ms);
+                igText("Input -> submit: avg %.2f ms, max %.2f ms", to_submit.average_ms, to_submit.max_ms);
+                igText("Input -> GPU done: avg %.2f ms, max %.2f ms", to_gpu.average_ms, to_gpu.max_ms);
+                igPlotLines_FloatPtr("##latency", frame_timer.input_to_gpu_ms, frame_timer.latency_count,
+                                     frame_timer.latency_count < FRAME_TIMER_HISTORY ? 0 : frame_timer.latency_head,
+                                     NULL, 0, FLT_MAX, (ImVec2){0, 40}, sizeof(float));
                 igEnd();
             }
 
             igRender();
+            PROFILE_END("ui");
+
+            PROFILE_BEGIN("sprites");
+            sprite_batch_begin(&sprite_batch);
+            if (show_sprites) {
+                const float extent = DUNGEON_SIZE * DUNGEON_TILE_SIZE;
+                const float t = now / 1000.0f;
+                for (int i = 0; i < sprites_count; i++) {
+                    // Cheap per sprite hash so the particles stay put between frames.
+                    uint32_t h = (uint32_t)i * 2654435761u;
+                    float fx = (h & 0xffff) / 65535.0f, fz = (h >> 16) / 65535.0f;
+                    sprite_batch_push(&sprite_batch, &(Sprite){
+                                                         .position = {fx * extent, 2 + sinf(t + i) * 1.5f, fz * extent},
+                                                         .size = {1.5f, 1.5f},
+                                                         .uv = {particle_uv[0], particle_uv[1], particle_uv[2],
+                                                                particle_uv[3]},
+                                                         .color = {0.4f + 0.6f * fx, 0.8f, 0.4f + 0.6f * fz, 0.8f},
+                                                         .page = particle_page,
+                                                     });
+                }
+            }
+
+            PROFILE_END("sprites");
 
+            PROFILE_BEGIN("swapchain_acquire");
             SDL_GPUCommandBuffer *cmdbuf = SDL_AcquireGPUCommandBuffer(device);
             if (cmdbuf == NULL) {
                 fprintf(stderr, "ERROR: SDL_AcquireGPUCommandBuffer failed: %s\n", SDL_GetError());
@@ -138,28 +497,29 @@ int main() {
             }
 
             SDL_GPUTexture *swapchain_texture;
-            if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, window, &swapchain_texture, NULL, NULL)) {
-                fprintf(stderr, "ERROR: SDL_WaitAndAcquireGPUSwapchainTexture failed: %s\n", SDL_GetError());
+            uint32_t swapchain_width, swapchain_height;
+            if (!swapchain_acquire(&swapchain_settings, cmdbuf, window, &swapchain_texture, &swapchain_width,
+                                   &swapchain_height)) {
+                fprintf(stderr, "ERROR: acquiring the swapchain texture failed: %s\n", SDL_GetError());
                 break;
             }
 
+            // No free image (or minimized), drop this frame. Pending input carries over to the next one.
             if (swapchain_texture == NULL) {
-                fprintf(stderr, "ERROR: swapchain_texture is NULL\n");
                 SDL_SubmitGPUCommandBuffer(cmdbuf);
-                break;
+                PROFILE_END("swapchain_acquire");
+                PROFILE_END("frame");
+                continue;
             }
+            PROFILE_END("swapchain_acquire");
 
-            SDL_GPUColorTargetInfo color_target_info = {0};
-            color_target_info.texture = swapchain_texture;
-            color_target_info.clear_color = COLOR_BLACK;
-            color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
-            color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+            PROFILE_BEGIN("record");
+            sprite_batch_upload(&sprite_batch, device, cmdbuf, &camera, &frame_arena);
 
             ImDrawData *imgui_draw_data = igGetDrawData();
             Imgui_ImplSDLGPU3_PrepareDrawData(imgui_draw_data, cmdbuf);
 
-            SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(cmdbuf, &color_target_info, 1, NULL);
-            CHECK(render_pass);
+            SDL_GPURenderPass *render_pass = dynamic_resolution_begin_scene(&dynres, cmdbuf, COLOR_BLACK);
 
             SDL_PushGPUVertexUniformData(cmdbuf, 0, camera.mvp, sizeof(mat4));
 
@@ -169,12 +529,85 @@ int main() {
             if (show_tiles) {
                 pipeline_render(&floor_tile_pipeline, render_pass);
             }
+            if (show_dungeon) {
+                pipeline_render(&level.pipeline, render_pass);
+            }
+            sprite_batch_render(&sprite_batch, render_pass);
 
-            ImGui_ImplSDLGPU3_RenderDrawData(imgui_draw_data, cmdbuf, render_pass, NULL);
+            SDL_EndGPURenderPass(render_pass);
+
+            // Repeats the pickable draws, in scene order, into the pixel under the mouse.
+            if (picking && !ioptr->WantCaptureMouse) {
+                float mouse_x, mouse_y;
+                SDL_GetMouseState(&mouse_x, &mouse_y);
+                int window_width, window_height;
+                SDL_GetWindowSize(window, &window_width, &window_height);
+                render_pass =
+                    picker_begin(&picker, cmdbuf, &camera, mouse_x, mouse_y, window_width, window_height);
+                if (show_cube)
+                    picker_draw(&picker, cmdbuf, render_pass, &cube_pipeline, PICK_ID_CUBE, PICK_CULL_BACK);
+                if (show_dungeon)
+                    picker_draw(&picker, cmdbuf, render_pass, &level.pipeline, PICK_ID_DUNGEON, PICK_PER_TRIANGLE);
+                picker_end(&picker, render_pass, &readback_queue, device);
+            }
+
+            // The scene without the UI, at whatever resolution it was rendered.
+            if (capture_requested) {
+                frame_capture_request(&capture, &readback_queue, device, dynres.texture, scene_format, dynres.width,
+                                      dynres.height);
+                capture_requested = false;
+            }
+
+            dynamic_resolution_blit(&dynres, cmdbuf, swapchain_texture, swapchain_width, swapchain_height);
 
+            // The UI goes on top of the upscaled scene at native resolution.
+            SDL_GPUColorTargetInfo color_target_info = {0};
+            color_target_info.texture = swapchain_texture;
+            color_target_info.load_op = SDL_GPU_LOADOP_LOAD;
+            color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+
+            render_pass = SDL_BeginGPURenderPass(cmdbuf, &color_target_info, 1, NULL);
+            CHECK(render_pass);
+            ImGui_ImplSDLGPU3_RenderDrawData(imgui_draw_data, cmdbuf, render_pass, NULL);
             SDL_EndGPURenderPass(render_pass);
-            CHECK(SDL_SubmitGPUCommandBuffer(cmdbuf));
+
+            PROFILE_END("record");
+
+            PROFILE_BEGIN("submit");
+            CHECK(frame_timer_submit(&frame_timer, device, cmdbuf, pending_input_ns));
+            pending_input_ns = 0;
+            if (!readback_queue_submit(&readback_queue, device))
+                fprintf(stderr, "ERROR: submitting readbacks failed: %s\n", SDL_GetError());
+            PROFILE_END("submit");
+            PROFILE_END("frame");
         }
     }
+
+    SDL_WaitForGPUIdle(device);
+    frame_timer_release(&frame_timer, device);
+    readback_queue_release(&readback_queue, device);
+    picker_release(&picker, device);
+    dynamic_resolution_release(&dynres, device);
+    sprite_batch_release(&sprite_batch, device);
+    texture_atlas_release(&sprite_atlas, device);
+    texture_array_release(&tile_textures, device);
+    pipeline_release(&level.pipeline, device);
+    pipeline_release(&floor_tile_pipeline, device);
+    pipeline_release(&cube_pipeline, device);
+    arena_free(&frame_arena);
+    arena_free(&level_arena);
+
+    ImGui_ImplSDLGPU3_Shutdown();
+    ImGui_ImplSDL3_Shutdown();
+    igDestroyContext(NULL);
+
+    // Let captures still being written finish.
+    while (SDL_GetAtomicInt(&capture.writing) > 0)
+        SDL_Delay(1);
+
+    SDL_ReleaseWindowFromGPUDevice(device, window);
+    SDL_DestroyGPUDevice(device);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
     return 0;
 }
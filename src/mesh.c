@@ -0,0 +1,261 @@
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The color tints the texture, sides are darkened a bit to fake some lighting.
+static const vec4 TOP_COLOR = {1.0f, 1.0f, 1.0f, 1.0f};
+static const vec4 SIDE_COLOR = {0.7f, 0.7f, 0.7f, 1.0f};
+
+// Cache size ACMR is reported for, a typical FIFO post-transform cache.
+#define MESH_ACMR_CACHE_SIZE 16
+
+// The uvs are filled in afterwards by mesh_build_dungeon.
+static void push_quad(Mesh *mesh, vec3 a, vec3 b, vec3 c, vec3 d, const vec4 color, TileLayer layer) {
+    uint32_t base = (uint32_t)mesh->vertices_count;
+    float *corners[4] = {a, b, c, d};
+    for (int i = 0; i < 4; i++) {
+        Vertex *v = &mesh->vertices[mesh->vertices_count++];
+        glm_vec4(corners[i], 1.0f, v->position);
+        glm_vec4_copy((float *)color, v->color);
+        glm_vec4_copy((vec4){0, 0, (float)layer, 0}, v->texcoord);
+    }
+    uint32_t *index = &mesh->indices[mesh->indices_count];
+    index[0] = base + 0;
+    index[1] = base + 1;
+    index[2] = base + 2;
+    index[3] = base + 2;
+    index[4] = base + 3;
+    index[5] = base + 0;
+    mesh->indices_count += 6;
+}
+
+static int wall_sides(const Dungeon *dungeon, int x, int y) {
+    return (dungeon_tile(dungeon, x - 1, y) == TILE_FLOOR) + (dungeon_tile(dungeon, x + 1, y) == TILE_FLOOR) +
+           (dungeon_tile(dungeon, x, y - 1) == TILE_FLOOR) + (dungeon_tile(dungeon, x, y + 1) == TILE_FLOOR);
+}
+
+size_t mesh_dungeon_triangles_count(const Dungeon *dungeon) {
+    size_t quads = 0;
+    for (int y = 0; y < dungeon->height; y++) {
+        for (int x = 0; x < dungeon->width; x++) {
+            switch (dungeon_tile(dungeon, x, y)) {
+            case TILE_FLOOR: {
+                quads += 1;
+            } break;
+            case TILE_WALL: {
+                quads += 1 + wall_sides(dungeon, x, y);
+            } break;
+            case TILE_EMPTY:
+                break;
+            }
+        }
+    }
+    return 2 * quads;
+}
+
+/*
+ * Floor tiles become a quad at y = 0 and wall tiles a block of wall_height. Only the sides of a wall that face a floor
+ * tile are emitted, everything else can't be seen. The map's x/y end up on the world's x/z.
+ */
+void mesh_build_dungeon(Mesh *mesh, Arena *arena, const Dungeon *dungeon, float tile_size, float wall_height) {
+    const size_t quads = mesh_dungeon_triangles_count(dungeon) / 2;
+    mesh->vertices = arena_push_array(arena, Vertex, 4 * quads);
+    mesh->indices = arena_push_array(arena, uint32_t, 6 * quads);
+    mesh->vertices_count = 0;
+    mesh->indices_count = 0;
+
+    const float h = wall_height;
+    for (int y = 0; y < dungeon->height; y++) {
+        for (int x = 0; x < dungeon->width; x++) {
+            float x0 = x * tile_size, x1 = (x + 1) * tile_size;
+            float z0 = y * tile_size, z1 = (y + 1) * tile_size;
+            switch (dungeon_tile(dungeon, x, y)) {
+            case TILE_FLOOR: {
+                push_quad(mesh, (vec3){x0, 0, z0}, (vec3){x0, 0, z1}, (vec3){x1, 0, z1}, (vec3){x1, 0, z0},
+                          TOP_COLOR, TILE_LAYER_FLOOR);
+            } break;
+            case TILE_WALL: {
+                push_quad(mesh, (vec3){x0, h, z0}, (vec3){x0, h, z1}, (vec3){x1, h, z1}, (vec3){x1, h, z0},
+                          TOP_COLOR, TILE_LAYER_WALL_TOP);
+                if (dungeon_tile(dungeon, x - 1, y) == TILE_FLOOR)
+                    push_quad(mesh, (vec3){x0, 0, z0}, (vec3){x0, h, z0}, (vec3){x0, h, z1}, (vec3){x0, 0, z1},
+                              SIDE_COLOR, TILE_LAYER_WALL_SIDE);
+                if (dungeon_tile(dungeon, x + 1, y) == TILE_FLOOR)
+                    push_quad(mesh, (vec3){x1, 0, z1}, (vec3){x1, h, z1}, (vec3){x1, h, z0}, (vec3){x1, 0, z0},
+                              SIDE_COLOR, TILE_LAYER_WALL_SIDE);
+                if (dungeon_tile(dungeon, x, y - 1) == TILE_FLOOR)
+                    push_quad(mesh, (vec3){x1, 0, z0}, (vec3){x1, h, z0}, (vec3){x0, h, z0}, (vec3){x0, 0, z0},
+                              SIDE_COLOR, TILE_LAYER_WALL_SIDE);
+                if (dungeon_tile(dungeon, x, y + 1) == TILE_FLOOR)
+                    push_quad(mesh, (vec3){x0, 0, z1}, (vec3){x0, h, z1}, (vec3){x1, h, z1}, (vec3){x1, 0, z1},
+                              SIDE_COLOR, TILE_LAYER_WALL_SIDE);
+            } break;
+            case TILE_EMPTY:
+                break;
+            }
+        }
+    }
+    assert(mesh->vertices_count == 4 * quads);
+
+    // World space uvs, one texture repeat per tile (and per wall height). Neighbouring quads of the same layer end up
+    // with identical corners, which mesh_optimize welds.
+    for (size_t i = 0; i < mesh->vertices_count; i++) {
+        Vertex *v = &mesh->vertices[i];
+        if ((TileLayer)v->texcoord[2] == TILE_LAYER_WALL_SIDE) {
+            // One of x/z is constant along a side.
+            v->texcoord[0] = (v->position[0] + v->position[2]) / tile_size;
+            v->texcoord[1] = 1 - v->position[1] / wall_height;
+        } else {
+            v->texcoord[0] = v->position[0] / tile_size;
+            v->texcoord[1] = v->position[2] / tile_size;
+        }
+    }
+}
+
+/*
+ * Which dungeon tile each triangle of a mesh_build_dungeon mesh belongs to, in the mesh's current triangle order.
+ * Wall sides lie on the border between two tiles, the triangle's winding gives a normal pointing into the wall.
+ */
+void mesh_dungeon_triangle_tiles(const Mesh *mesh, const Dungeon *dungeon, float tile_size, uint32_t *tiles) {
+    for (size_t t = 0; t < mesh->indices_count / 3; t++) {
+        const uint32_t *triangle = &mesh->indices[3 * t];
+        vec3 a, b, c, ab, ac, normal, center;
+        glm_vec3(mesh->vertices[triangle[0]].position, a);
+        glm_vec3(mesh->vertices[triangle[1]].position, b);
+        glm_vec3(mesh->vertices[triangle[2]].position, c);
+        glm_vec3_sub(b, a, ab);
+        glm_vec3_sub(c, a, ac);
+        glm_vec3_cross(ab, ac, normal);
+        glm_vec3_normalize(normal);
+
+        glm_vec3_add(a, b, center);
+        glm_vec3_add(center, c, center);
+        glm_vec3_scale(center, 1.0f / 3, center);
+        glm_vec3_muladds(normal, tile_size * 0.01f, center);
+
+        int x = (int)glm_clamp(floorf(center[0] / tile_size), 0, dungeon->width - 1);
+        int y = (int)glm_clamp(floorf(center[2] / tile_size), 0, dungeon->height - 1);
+        tiles[t] = (uint32_t)(y * dungeon->width + x);
+    }
+}
+
+/*
+ * Welds shared corners, reorders triangles for the post-transform cache and vertices for fetch locality. Overdraw
+ * clustering is optional since it only helps with a depth test. Everything happens in place, the mesh only shrinks.
+ */
+void mesh_optimize(Mesh *mesh, Arena *scratch, bool reduce_overdraw, MeshOptimizeStats *stats) {
+    ArenaMark mark = arena_mark(scratch);
+    void *buffer =
+        arena_alloc(scratch, mesh_optimizer_scratch_size(mesh->indices_count, mesh->vertices_count, sizeof(Vertex)));
+
+    stats->vertices_before = mesh->vertices_count;
+    stats->acmr_unwelded =
+        mesh_optimizer_acmr(mesh->indices, mesh->indices_count, mesh->vertices_count, MESH_ACMR_CACHE_SIZE, buffer);
+
+    mesh->vertices_count = mesh_optimizer_weld(mesh->vertices, mesh->vertices_count, sizeof(Vertex), mesh->indices,
+                                               mesh->indices_count, buffer);
+    stats->acmr_before =
+        mesh_optimizer_acmr(mesh->indices, mesh->indices_count, mesh->vertices_count, MESH_ACMR_CACHE_SIZE, buffer);
+    mesh_optimizer_vertex_cache(mesh->indices, mesh->indices_count, mesh->vertices_count, buffer);
+    if (reduce_overdraw) {
+        mesh_optimizer_overdraw(mesh->indices, mesh->indices_count, mesh->vertices[0].position, mesh->vertices_count,
+                                sizeof(Vertex), MESH_ACMR_CACHE_SIZE, 1.05f, buffer);
+    }
+    mesh->vertices_count = mesh_optimizer_vertex_fetch(mesh->vertices, mesh->vertices_count, sizeof(Vertex),
+                                                       mesh->indices, mesh->indices_count, buffer);
+
+    stats->vertices_after = mesh->vertices_count;
+    stats->acmr_after =
+        mesh_optimizer_acmr(mesh->indices, mesh->indices_count, mesh->vertices_count, MESH_ACMR_CACHE_SIZE, buffer);
+    arena_rewind(scratch, mark);
+}
+
+/*
+ * A square line list grid in the y = 0 plane. A grid graph G_(n,n) has n^2 nodes and 2n(n-1) edges, each edge is one
+ * line (two indices).
+ */
+void mesh_build_grid(Mesh *mesh, Arena *arena, size_t vertices_per_row, float start, float step, const vec4 color) {
+    const size_t n = vertices_per_row;
+    mesh->vertices_count = n * n;
+    mesh->indices_count = 4 * n * (n - 1);
+    mesh->vertices = arena_push_array(arena, Vertex, mesh->vertices_count);
+    mesh->indices = arena_push_array(arena, uint32_t, mesh->indices_count);
+
+    for (size_t x = 0; x < n; x++) {
+        for (size_t z = 0; z < n; z++) {
+            mesh->vertices[x * n + z] = (Vertex){
+                {x * step + start, 0, z * step + start, 1},
+                {color[0], color[1], color[2], color[3]},
+            };
+        }
+    }
+
+    uint32_t *index = mesh->indices;
+    for (size_t a = 0; a < n; a++) {
+        for (size_t b = 0; b < n - 1; b++) {
+            // Along z, then along x.
+            *index++ = a * n + b;
+            *index++ = a * n + b + 1;
+            *index++ = b * n + a;
+            *index++ = (b + 1) * n + a;
+        }
+    }
+    assert((size_t)(index - mesh->indices) == mesh->indices_count);
+}
+
+static Vertex CubeVertices[] = {
+    // 0 fbl
+    {{25, 25, 25, 1.0}, {1.0, 0.0, 0.0, 1.0}},
+    // 1 ftl
+    {{25, 75, 25, 1.0}, {0.0, 1.0, 0.0, 1.0}},
+    // 2 fbr
+    {{75, 25, 25, 1.0}, {0.0, 0.0, 1.0, 1.0}},
+    // 3 ftr
+    {{75, 75, 25, 1.0}, {1.0, 1.0, 0.0, 1.0}},
+
+    // 4 bbr
+    {{25, 25, -25, 1.0}, {1.0, 0.0, 0.0, 1.0}},
+    // 5 btr
+    {{25, 75, -25, 1.0}, {0.0, 1.0, 0.0, 1.0}},
+    // 6 bbl
+    {{75, 25, -25, 1.0}, {0.0, 0.0, 1.0, 1.0}},
+    // 7 btl
+    {{75, 75, -25, 1.0}, {1.0, 1.0, 0.0, 1.0}},
+};
+
+// clang-format off
+static uint32_t CubeIndices[] = {
+    // front
+    0, 1, 2,
+    1, 3, 2,
+    // right
+    2, 3, 6,
+    3, 7, 6,
+    // left
+    4, 5, 0,
+    5, 1, 0,
+    // back
+    6, 7, 4,
+    7, 5, 4,
+};
+// clang-format on
+
+// Points at static data, nothing to free.
+void mesh_build_cube(Mesh *mesh) {
+    mesh->vertices = CubeVertices;
+    mesh->vertices_count = sizeof(CubeVertices) / sizeof(Vertex);
+    mesh->indices = CubeIndices;
+    mesh->indices_count = sizeof(CubeIndices) / sizeof(uint32_t);
+}
+
+// Vertices followed by indices, the layout pipeline uploads copy from. Returns the bytes written.
+size_t mesh_pack(void *dest, const Mesh *mesh) {
+    const size_t vertices_size = sizeof(Vertex) * mesh->vertices_count;
+    const size_t indices_size = sizeof(uint32_t) * mesh->indices_count;
+    memcpy(dest, mesh->vertices, vertices_size);
+    memcpy((uint8_t *)dest + vertices_size, mesh->indices, indices_size);
+    return vertices_size + indices_size;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "dungeon.h"
+
+typedef enum { TILE_LAYER_FLOOR, TILE_LAYER_WALL_TOP, TILE_LAYER_WALL_SIDE, TILE_LAYER_COUNT } TileLayer;
+
+typedef struct {
+    vec4 position, color;
+    // u, v, texture array layer, unused.
+    vec4 texcoord;
+} Vertex;
+
+typedef struct {
+    Vertex *vertices;
+    size_t vertices_count;
+    uint32_t *indices;
+    size_t indices_count;
+} Mesh;
+
+typedef struct {
+    size_t vertices_before;
+    size_t vertices_after;
+    // Average cache miss ratio, vertex shader runs per triangle. Unwelded is the mesh as built, where nothing is shared
+    // and every triangle misses all three vertices. Before is welded but still in build order, so before -> after is
+    // what the reordering alone gains.
+    float acmr_unwelded;
+    float acmr_before;
+    float acmr_after;
+} MeshOptimizeStats;
+
+size_t mesh_dungeon_triangles_count(const Dungeon *dungeon);
+void mesh_build_dungeon(Mesh *mesh, Arena *arena, const Dungeon *dungeon, float tile_size, float wall_height);
+void mesh_build_grid(Mesh *mesh, Arena *arena, size_t vertices_per_row, float start, float step, const vec4 color);
+void mesh_build_cube(Mesh *mesh);
+size_t mesh_pack(void *dest, const Mesh *mesh);
+void mesh_dungeon_triangle_tiles(const Mesh *mesh, const Dungeon *dungeon, float tile_size, uint32_t *tiles);
+void mesh_optimize(Mesh *mesh, Arena *scratch, bool reduce_overdraw, MeshOptimizeStats *stats);
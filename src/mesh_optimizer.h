@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Index and vertex buffer reordering for indexed triangle lists. Standalone: it only needs libc and never allocates,
+ * every pass works in a caller provided scratch buffer of at least mesh_optimizer_scratch_size() bytes (aligned for
+ * uint32_t/float). Indices and vertices are rewritten in place.
+ *
+ * The usual order is weld (a soup of unshared vertices gives the cache nothing to work with), vertex_cache, then
+ * optionally overdraw (which keeps most of the cache locality), then vertex_fetch last since it renumbers the
+ * vertices.
+ */
+
+// Post-transform cache size the Forsyth scoring assumes.
+#define MESH_OPTIMIZER_CACHE_SIZE 32
+
+size_t mesh_optimizer_scratch_size(size_t indices_count, size_t vertices_count, size_t vertex_size);
+
+size_t mesh_optimizer_weld(void *vertices, size_t vertices_count, size_t vertex_size, uint32_t *indices,
+                           size_t indices_count, void *scratch);
+float mesh_optimizer_acmr(const uint32_t *indices, size_t indices_count, size_t vertices_count, uint32_t cache_size,
+                          void *scratch);
+void mesh_optimizer_vertex_cache(uint32_t *indices, size_t indices_count, size_t vertices_count, void *scratch);
+void mesh_optimizer_overdraw(uint32_t *indices, size_t indices_count, const float *positions, size_t vertices_count,
+                             size_t vertex_stride, uint32_t cache_size, float threshold, void *scratch);
+size_t mesh_optimizer_vertex_fetch(void *vertices, size_t vertices_count, size_t vertex_size, uint32_t *indices,
+                                   size_t indices_count, void *scratch);
@@ -0,0 +1,36 @@
+#include <metal_stdlib>
+using namespace metal;
+
+struct VertexInput {
+    float4 position [[attribute(0)]];
+    float4 color    [[attribute(1)]];
+    float4 texcoord [[attribute(2)]];
+};
+
+struct PickUniforms {
+    float4x4 mvp;
+    uint base_id;
+    uint per_triangle;
+};
+
+struct FragmentInput {
+    float4 position [[position]];
+    uint base_id [[flat]];
+    uint per_triangle [[flat]];
+};
+
+vertex FragmentInput vertexShader(
+    uint vertexId [[vertex_id]],
+    constant PickUniforms *uniforms [[buffer(0)]],
+    VertexInput input [[stage_in]]) {
+    FragmentInput frag = {};
+    frag.position = uniforms->mvp * input.position;
+    frag.base_id = uniforms->base_id;
+    frag.per_triangle = uniforms->per_triangle;
+    return frag;
+}
+
+// The draw's base id, plus the triangle's index within the draw if it asked for per triangle ids.
+fragment uint fragmentShader(FragmentInput input [[stage_in]], uint triangle [[primitive_id]]) {
+    return input.base_id + input.per_triangle * triangle;
+}
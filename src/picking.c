@@ -0,0 +1,156 @@
+#include "picking.h"
+
+#include "constants.h"
+#include "sdl_utils.h"
+
+#include <stddef.h>
+
+typedef struct {
+    mat4 mvp;
+    uint32_t base_id;
+    uint32_t per_triangle;
+    uint32_t padding[2];
+} PickUniforms;
+
+static SDL_GPUGraphicsPipeline *picker_create_pipeline(SDL_GPUDevice *device, SDL_GPUShader **shaders,
+                                                       SDL_GPUCullMode cull_mode) {
+    SDL_GPUGraphicsPipelineCreateInfo pipeline_info = {
+        .target_info =
+            {
+                .num_color_targets = 1,
+                .color_target_descriptions =
+                    (SDL_GPUColorTargetDescription[]){{.format = SDL_GPU_TEXTUREFORMAT_R32_UINT}},
+            },
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .vertex_shader = shaders[0],
+        .fragment_shader = shaders[1],
+        .vertex_input_state =
+            (SDL_GPUVertexInputState){
+                .vertex_buffer_descriptions =
+                    (SDL_GPUVertexBufferDescription[]){
+                        {
+                            .slot = 0,
+                            .pitch = sizeof(Vertex),
+                            .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                            .instance_step_rate = 0,
+                        },
+                    },
+                .num_vertex_buffers = 1,
+                .vertex_attributes =
+                    (SDL_GPUVertexAttribute[]){
+                        {
+                            .location = 0,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                            .offset = offsetof(Vertex, position),
+                        },
+                        {
+                            .location = 1,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                            .offset = offsetof(Vertex, color),
+                        },
+                        {
+                            .location = 2,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                            .offset = offsetof(Vertex, texcoord),
+                        },
+                    },
+                .num_vertex_attributes = 3,
+            },
+        .rasterizer_state =
+            (SDL_GPURasterizerState){
+                .cull_mode = cull_mode,
+                .front_face = SDL_GPU_FRONTFACE_CLOCKWISE,
+                .fill_mode = SDL_GPU_FILLMODE_FILL,
+            },
+    };
+
+    SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_info);
+    CHECK(pipeline);
+    return pipeline;
+}
+
+void picker_init(Picker *picker, SDL_GPUDevice *device) {
+    *picker = (Picker){0};
+
+    SDL_GPUShader *shaders[2] = {0};
+    load_shaders(device, "src/pick.metal", 0, shaders);
+    picker->pipelines[false] = picker_create_pipeline(device, shaders, SDL_GPU_CULLMODE_NONE);
+    picker->pipelines[true] = picker_create_pipeline(device, shaders, SDL_GPU_CULLMODE_BACK);
+    SDL_ReleaseGPUShader(device, shaders[0]);
+    SDL_ReleaseGPUShader(device, shaders[1]);
+
+    picker->target = SDL_CreateGPUTexture(device, &(SDL_GPUTextureCreateInfo){
+                                                      .type = SDL_GPU_TEXTURETYPE_2D,
+                                                      .format = SDL_GPU_TEXTUREFORMAT_R32_UINT,
+                                                      .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+                                                      .width = 1,
+                                                      .height = 1,
+                                                      .layer_count_or_depth = 1,
+                                                      .num_levels = 1,
+                                                  });
+    CHECK(picker->target);
+}
+
+/*
+ * There is no depth buffer, so like the scene itself the last draw covering the pixel wins. Picking the same draws in
+ * the same order as the scene keeps the result in line with what's on screen.
+ */
+SDL_GPURenderPass *picker_begin(Picker *picker, SDL_GPUCommandBuffer *cmdbuf, const Camera *camera, float mouse_x,
+                                float mouse_y, float window_width, float window_height) {
+    // One window pixel is 2 / size wide in NDC, scaling by the size makes it the whole target.
+    float ndc_x = 2 * mouse_x / window_width - 1;
+    float ndc_y = 1 - 2 * mouse_y / window_height;
+    mat4 pick = GLM_MAT4_IDENTITY_INIT;
+    pick[0][0] = window_width;
+    pick[1][1] = window_height;
+    pick[3][0] = -ndc_x * window_width;
+    pick[3][1] = -ndc_y * window_height;
+    glm_mat4_mul(pick, (vec4 *)camera->mvp, picker->mvp);
+
+    SDL_GPUColorTargetInfo color_target_info = {0};
+    color_target_info.texture = picker->target;
+    color_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
+    color_target_info.store_op = SDL_GPU_STOREOP_STORE;
+    SDL_GPURenderPass *render_pass = SDL_BeginGPURenderPass(cmdbuf, &color_target_info, 1, NULL);
+    CHECK(render_pass);
+    return render_pass;
+}
+
+void picker_draw(Picker *picker, SDL_GPUCommandBuffer *cmdbuf, SDL_GPURenderPass *render_pass,
+                 const Pipeline *pipeline, uint32_t base_id, PickFlags flags) {
+    PickUniforms uniforms = {.base_id = base_id, .per_triangle = (flags & PICK_PER_TRIANGLE) != 0};
+    glm_mat4_copy(picker->mvp, uniforms.mvp);
+    SDL_PushGPUVertexUniformData(cmdbuf, 0, &uniforms, sizeof(uniforms));
+
+    SDL_BindGPUGraphicsPipeline(render_pass, picker->pipelines[(flags & PICK_CULL_BACK) != 0]);
+    SDL_BindGPUVertexBuffers(render_pass, 0, &(SDL_GPUBufferBinding){.buffer = pipeline->vertex_buffer}, 1);
+    SDL_BindGPUIndexBuffer(render_pass, &(SDL_GPUBufferBinding){.buffer = pipeline->index_buffer, .offset = 0},
+                           SDL_GPU_INDEXELEMENTSIZE_32BIT);
+    SDL_DrawGPUIndexedPrimitives(render_pass, pipeline->indices_count, 1, 0, 0, 0);
+}
+
+static void picker_on_readback(ReadbackHandle handle, const void *data, size_t size, void *user_data) {
+    Picker *picker = user_data;
+    // Two batches can finish in the same poll, don't let an older result overwrite a newer one.
+    if (handle < picker->hovered_handle || size < sizeof(uint32_t))
+        return;
+    picker->hovered_handle = handle;
+    SDL_memcpy(&picker->hovered_id, data, sizeof(uint32_t));
+}
+
+// If the readback queue is full this frame's pick is simply dropped.
+void picker_end(Picker *picker, SDL_GPURenderPass *render_pass, ReadbackQueue *queue, SDL_GPUDevice *device) {
+    SDL_EndGPURenderPass(render_pass);
+    readback_texture(queue, device, &(SDL_GPUTextureRegion){.texture = picker->target, .w = 1, .h = 1, .d = 1},
+                     SDL_GPU_TEXTUREFORMAT_R32_UINT, picker_on_readback, picker);
+}
+
+void picker_release(Picker *picker, SDL_GPUDevice *device) {
+    SDL_ReleaseGPUGraphicsPipeline(device, picker->pipelines[false]);
+    SDL_ReleaseGPUGraphicsPipeline(device, picker->pipelines[true]);
+    SDL_ReleaseGPUTexture(device, picker->target);
+    *picker = (Picker){0};
+}
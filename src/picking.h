@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+#include <cglm/cglm.h>
+
+#include "camera.h"
+#include "pipeline.h"
+#include "readback.h"
+
+typedef enum {
+    PICK_CULL_BACK = 1 << 0,
+    // Each triangle gets base_id + its index in the draw, for meshes that map triangles back to something.
+    PICK_PER_TRIANGLE = 1 << 1,
+} PickFlags;
+
+/*
+ * Object ID picking. Pickable draws are repeated into a 1x1 R32_UINT target through a projection that blows the pixel
+ * under the mouse up to the whole target, so the pass costs next to nothing. The ID comes back through a ReadbackQueue
+ * a few frames later, one pick is requested per frame and the newest result wins. 0 means nothing was hit.
+ */
+typedef struct {
+    // Indexed by whether back faces are culled, to match the pipeline being picked.
+    SDL_GPUGraphicsPipeline *pipelines[2];
+    SDL_GPUTexture *target;
+    mat4 mvp;
+
+    uint32_t hovered_id;
+    ReadbackHandle hovered_handle;
+} Picker;
+
+void picker_init(Picker *picker, SDL_GPUDevice *device);
+SDL_GPURenderPass *picker_begin(Picker *picker, SDL_GPUCommandBuffer *cmdbuf, const Camera *camera, float mouse_x,
+                                float mouse_y, float window_width, float window_height);
+void picker_draw(Picker *picker, SDL_GPUCommandBuffer *cmdbuf, SDL_GPURenderPass *render_pass,
+                 const Pipeline *pipeline, uint32_t base_id, PickFlags flags);
+void picker_end(Picker *picker, SDL_GPURenderPass *render_pass, ReadbackQueue *queue, SDL_GPUDevice *device);
+void picker_release(Picker *picker, SDL_GPUDevice *device);
@@ -4,20 +4,23 @@
 #include <SDL3/SDL_gpu.h>
 #include <cglm/cglm.h>
 
-typedef struct {
-    vec4 position, color;
-} Vertex;
+#include "mesh.h"
+#include "texture.h"
 
 typedef struct {
     SDL_GPUGraphicsPipeline *pipeline;
     SDL_GPUBuffer *vertex_buffer;
     SDL_GPUBuffer *index_buffer;
-    Vertex *vertices;
-    size_t vertices_count;
-    uint16_t *indices;
     size_t indices_count;
+    // Optional, bound to fragment sampler slot 0. Not owned by the pipeline.
+    SDL_GPUTexture *texture;
+    SDL_GPUSampler *sampler;
 } Pipeline;
 
-void cube_pipeline_init(Pipeline *pipeline, SDL_Window *window, SDL_GPUDevice *device);
-void floor_tile_pipeline_init(Pipeline *pipeline, SDL_Window *window, SDL_GPUDevice *device);
+void cube_pipeline_init(Pipeline *pipeline, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device);
+void floor_tile_pipeline_init(Pipeline *pipeline, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device,
+                              Arena *scratch);
+void mesh_pipeline_init(Pipeline *pipeline, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device, const Mesh *mesh,
+                        const TextureArray *textures);
 void pipeline_render(Pipeline *pipeline, SDL_GPURenderPass *render_pass);
+void pipeline_release(Pipeline *pipeline, SDL_GPUDevice *device);
@@ -0,0 +1,131 @@
+#include "profiler.h"
+
+#include <stdio.h>
+
+static SDL_AtomicPointer profile_threads[PROFILE_MAX_THREADS];
+static SDL_AtomicInt profile_threads_count;
+static _Thread_local ProfileThread *profile_current;
+static _Thread_local bool profile_no_slot;
+
+// Threads get their ring on their first event. Slots are never given back, threads past the limit go unrecorded.
+static ProfileThread *profile_thread_get(void) {
+    if (profile_current || profile_no_slot)
+        return profile_current;
+
+    int index = SDL_AddAtomicInt(&profile_threads_count, 1);
+    if (index >= PROFILE_MAX_THREADS) {
+        profile_no_slot = true;
+        return NULL;
+    }
+    ProfileThread *thread = SDL_calloc(1, sizeof(ProfileThread));
+    if (thread == NULL) {
+        profile_no_slot = true;
+        return NULL;
+    }
+    SDL_snprintf(thread->name, sizeof(thread->name), "thread %d", index);
+    SDL_SetAtomicPointer(&profile_threads[index], thread);
+    profile_current = thread;
+    return thread;
+}
+
+void profile_record(const char *name, ProfilePhase phase) {
+    ProfileThread *thread = profile_thread_get();
+    if (thread == NULL)
+        return;
+    Uint32 head = SDL_GetAtomicU32(&thread->head);
+    ProfileEvent *event = &thread->events[head & (PROFILE_RING_SIZE - 1)];
+    event->name = name;
+    event->ns = SDL_GetTicksNS();
+    event->phase = phase;
+    SDL_SetAtomicU32(&thread->head, head + 1);
+}
+
+// Shown as the thread's name in the trace viewer.
+void profile_thread_name(const char *name) {
+    ProfileThread *thread = profile_thread_get();
+    if (thread)
+        SDL_strlcpy(thread->name, name, sizeof(thread->name));
+}
+
+/*
+ * Writes the last `window_ns` of every thread as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+ * Zones cut by the window's start are dropped, zones still open are closed at the newest event. Safe to call while
+ * other threads keep recording.
+ */
+bool profile_dump(const char *path, uint64_t window_ns) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: can't open %s for writing\n", path);
+        return false;
+    }
+
+    // Only the dumping thread uses it, the rings are copied out before the slow formatting.
+    ProfileEvent *events = SDL_malloc(sizeof(ProfileEvent) * PROFILE_RING_SIZE);
+    if (events == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    uint64_t now = SDL_GetTicksNS();
+    uint64_t since = now > window_ns ? now - window_ns : 0;
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    int threads_count = SDL_min(SDL_GetAtomicInt(&profile_threads_count), PROFILE_MAX_THREADS);
+    for (int t = 0; t < threads_count; t++) {
+        ProfileThread *thread = SDL_GetAtomicPointer(&profile_threads[t]);
+        if (thread == NULL)
+            continue;
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t, thread->name);
+        first = false;
+
+        /*
+         * Everything before head is published, but the owning thread keeps going while this copies. Event i's slot is
+         * rewritten once it gets to event i + PROFILE_RING_SIZE, so after copying, head is read again and every event
+         * it may have reached (including the one it could be writing right now) is thrown away.
+         */
+        Uint32 head = SDL_GetAtomicU32(&thread->head);
+        Uint32 count = SDL_min(head, PROFILE_RING_SIZE);
+        Uint32 start = head - count;
+        for (Uint32 i = 0; i < count; i++)
+            events[i] = thread->events[(start + i) & (PROFILE_RING_SIZE - 1)];
+        SDL_MemoryBarrierAcquire();
+        Uint32 written = SDL_GetAtomicU32(&thread->head) - start;
+        Uint32 stale = written >= PROFILE_RING_SIZE ? SDL_min(written - PROFILE_RING_SIZE + 1, count) : 0;
+
+        const char *open[64];
+        int depth = 0;
+        uint64_t last_ns = since;
+        for (Uint32 i = stale; i < count; i++) {
+            const ProfileEvent *event = &events[i];
+            if (event->ns < since)
+                continue;
+            if (event->phase == PROFILE_PHASE_BEGIN) {
+                if (depth < (int)SDL_arraysize(open))
+                    open[depth] = event->name;
+                depth++;
+            } else {
+                // Its begin is older than the window.
+                if (depth == 0)
+                    continue;
+                depth--;
+            }
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", event->name,
+                    event->phase == PROFILE_PHASE_BEGIN ? 'B' : 'E', event->ns / 1e3, t);
+            last_ns = event->ns;
+        }
+        for (depth = SDL_min(depth, (int)SDL_arraysize(open)); depth > 0; depth--) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", open[depth - 1],
+                    last_ns / 1e3, t);
+        }
+    }
+
+    SDL_free(events);
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    if (!ok)
+        fprintf(stderr, "ERROR: writing %s failed\n", path);
+    return ok;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#define PROFILE_MAX_THREADS 32
+// Events per thread, a power of two. Every zone is two events.
+#define PROFILE_RING_SIZE 65536
+
+typedef enum { PROFILE_PHASE_BEGIN, PROFILE_PHASE_END } ProfilePhase;
+
+typedef struct {
+    // Zone names must be string literals (or otherwise outlive the profiler).
+    const char *name;
+    uint64_t ns;
+    ProfilePhase phase;
+} ProfileEvent;
+
+/*
+ * One per thread that records zones. Only the owning thread writes, publishing each event by bumping `head`, so
+ * recording takes no lock. Old events are overwritten once the ring wraps.
+ */
+typedef struct {
+    char name[32];
+    SDL_AtomicU32 head;
+    ProfileEvent events[PROFILE_RING_SIZE];
+} ProfileThread;
+
+/*
+ * Nested CPU zones, every PROFILE_BEGIN needs a PROFILE_END on the same thread (mind early returns and continues).
+ * Building without DUNG_PROFILE compiles them out.
+ */
+#ifdef DUNG_PROFILE
+#define PROFILE_BEGIN(name) profile_record((name), PROFILE_PHASE_BEGIN)
+#define PROFILE_END(name) profile_record((name), PROFILE_PHASE_END)
+#define PROFILE_THREAD(name) profile_thread_name(name)
+#else
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+void profile_record(const char *name, ProfilePhase phase);
+void profile_thread_name(const char *name);
+bool profile_dump(const char *path, uint64_t window_ns);
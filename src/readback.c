@@ -0,0 +1,179 @@
+#include "readback.h"
+
+#include <stdio.h>
+
+// Reuses a free slot's transfer buffer when it's big enough, otherwise replaces the buffer of any free slot.
+static ReadbackSlot *readback_acquire_slot(ReadbackQueue *queue, SDL_GPUDevice *device, uint32_t size) {
+    ReadbackSlot *slot = NULL;
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+        ReadbackSlot *candidate = &queue->slots[i];
+        if (candidate->state != READBACK_FREE)
+            continue;
+        if (candidate->capacity >= size) {
+            slot = candidate;
+            break;
+        }
+        if (slot == NULL)
+            slot = candidate;
+    }
+    if (slot == NULL)
+        return NULL;
+
+    if (slot->capacity < size) {
+        if (slot->transfer_buffer)
+            SDL_ReleaseGPUTransferBuffer(device, slot->transfer_buffer);
+        slot->transfer_buffer = SDL_CreateGPUTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
+                                                                        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+                                                                        .size = size,
+                                                                    });
+        slot->capacity = slot->transfer_buffer ? size : 0;
+        if (slot->transfer_buffer == NULL)
+            return NULL;
+    }
+
+    if (++queue->next_handle == 0)
+        queue->next_handle = 1;
+    slot->handle = queue->next_handle;
+    slot->size = size;
+    slot->fence = NULL;
+    slot->state = READBACK_RECORDED;
+    queue->in_flight_count++;
+    return slot;
+}
+
+// The texture has to stay alive until the queue is submitted. Rows come back tightly packed.
+ReadbackHandle readback_texture(ReadbackQueue *queue, SDL_GPUDevice *device, const SDL_GPUTextureRegion *region,
+                                SDL_GPUTextureFormat format, ReadbackCallback callback, void *user_data) {
+    uint32_t size = region->w * region->h * SDL_max(region->d, 1) * SDL_GPUTextureFormatTexelBlockSize(format);
+    ReadbackSlot *slot = readback_acquire_slot(queue, device, size);
+    if (slot == NULL)
+        return 0;
+    slot->is_texture = true;
+    slot->texture_region = *region;
+    slot->callback = callback;
+    slot->user_data = user_data;
+    return slot->handle;
+}
+
+ReadbackHandle readback_buffer(ReadbackQueue *queue, SDL_GPUDevice *device, const SDL_GPUBufferRegion *region,
+                               ReadbackCallback callback, void *user_data) {
+    ReadbackSlot *slot = readback_acquire_slot(queue, device, region->size);
+    if (slot == NULL)
+        return 0;
+    slot->is_texture = false;
+    slot->buffer_region = *region;
+    slot->callback = callback;
+    slot->user_data = user_data;
+    return slot->handle;
+}
+
+/*
+ * Records every request made since the last submit into one command buffer. Call it after submitting the frame's
+ * command buffer, the GPU runs them in submission order.
+ */
+bool readback_queue_submit(ReadbackQueue *queue, SDL_GPUDevice *device) {
+    bool any = false;
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++)
+        any |= queue->slots[i].state == READBACK_RECORDED;
+    if (!any)
+        return true;
+
+    SDL_GPUCommandBuffer *cmdbuf = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUFence *fence = NULL;
+    if (cmdbuf) {
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmdbuf);
+        for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+            ReadbackSlot *slot = &queue->slots[i];
+            if (slot->state != READBACK_RECORDED)
+                continue;
+            if (slot->is_texture) {
+                SDL_DownloadFromGPUTexture(copy_pass, &slot->texture_region,
+                                           &(SDL_GPUTextureTransferInfo){
+                                               .transfer_buffer = slot->transfer_buffer,
+                                               .offset = 0,
+                                               .pixels_per_row = slot->texture_region.w,
+                                               .rows_per_layer = slot->texture_region.h,
+                                           });
+            } else {
+                SDL_DownloadFromGPUBuffer(
+                    copy_pass, &slot->buffer_region,
+                    &(SDL_GPUTransferBufferLocation){.transfer_buffer = slot->transfer_buffer, .offset = 0});
+            }
+        }
+        SDL_EndGPUCopyPass(copy_pass);
+        fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdbuf);
+    }
+
+    // On failure the requests are dropped, their sources may not outlive this frame.
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+        ReadbackSlot *slot = &queue->slots[i];
+        if (slot->state != READBACK_RECORDED)
+            continue;
+        if (fence) {
+            slot->fence = fence;
+            slot->state = READBACK_SUBMITTED;
+        } else {
+            slot->state = READBACK_FREE;
+            queue->in_flight_count--;
+        }
+    }
+    return fence != NULL;
+}
+
+static void readback_deliver(ReadbackQueue *queue, SDL_GPUDevice *device, ReadbackSlot *slot) {
+    void *data = SDL_MapGPUTransferBuffer(device, slot->transfer_buffer, false);
+    if (data) {
+        slot->callback(slot->handle, data, slot->size, slot->user_data);
+        SDL_UnmapGPUTransferBuffer(device, slot->transfer_buffer);
+    } else {
+        fprintf(stderr, "ERROR: SDL_MapGPUTransferBuffer failed: %s\n", SDL_GetError());
+    }
+    slot->state = READBACK_FREE;
+    slot->fence = NULL;
+    queue->in_flight_count--;
+}
+
+// Hands finished requests to their callbacks. Never blocks, call it once per frame.
+void readback_queue_poll(ReadbackQueue *queue, SDL_GPUDevice *device) {
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+        ReadbackSlot *slot = &queue->slots[i];
+        if (slot->state != READBACK_SUBMITTED || !SDL_QueryGPUFence(device, slot->fence))
+            continue;
+
+        // The rest of the batch is done too, deliver it before the shared fence goes away.
+        SDL_GPUFence *fence = slot->fence;
+        for (size_t j = i; j < READBACK_MAX_REQUESTS; j++) {
+            if (queue->slots[j].state == READBACK_SUBMITTED && queue->slots[j].fence == fence)
+                readback_deliver(queue, device, &queue->slots[j]);
+        }
+        SDL_ReleaseGPUFence(device, fence);
+    }
+}
+
+bool readback_pending(const ReadbackQueue *queue, ReadbackHandle handle) {
+    if (handle == 0)
+        return false;
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+        if (queue->slots[i].handle == handle)
+            return queue->slots[i].state != READBACK_FREE;
+    }
+    return false;
+}
+
+// Pending requests are dropped without calling back. Wait for the GPU to go idle first.
+void readback_queue_release(ReadbackQueue *queue, SDL_GPUDevice *device) {
+    for (size_t i = 0; i < READBACK_MAX_REQUESTS; i++) {
+        ReadbackSlot *slot = &queue->slots[i];
+        if (slot->state == READBACK_SUBMITTED) {
+            SDL_GPUFence *fence = slot->fence;
+            for (size_t j = i; j < READBACK_MAX_REQUESTS; j++) {
+                if (queue->slots[j].state == READBACK_SUBMITTED && queue->slots[j].fence == fence)
+                    queue->slots[j].state = READBACK_FREE;
+            }
+            SDL_ReleaseGPUFence(device, fence);
+        }
+        if (slot->transfer_buffer)
+            SDL_ReleaseGPUTransferBuffer(device, slot->transfer_buffer);
+    }
+    *queue = (ReadbackQueue){0};
+}
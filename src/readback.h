@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#define READBACK_MAX_REQUESTS 16
+
+// 0 is never handed out, so it can mean "no request".
+typedef uint32_t ReadbackHandle;
+
+// `data` is only valid for the duration of the call.
+typedef void (*ReadbackCallback)(ReadbackHandle handle, const void *data, size_t size, void *user_data);
+
+typedef enum { READBACK_FREE, READBACK_RECORDED, READBACK_SUBMITTED } ReadbackState;
+
+typedef struct {
+    ReadbackState state;
+    ReadbackHandle handle;
+    // Kept while the slot is free so later requests of the same size reuse it.
+    SDL_GPUTransferBuffer *transfer_buffer;
+    uint32_t capacity;
+    uint32_t size;
+
+    bool is_texture;
+    SDL_GPUTextureRegion texture_region;
+    SDL_GPUBufferRegion buffer_region;
+
+    // Shared by every request submitted in the same batch.
+    SDL_GPUFence *fence;
+    ReadbackCallback callback;
+    void *user_data;
+} ReadbackSlot;
+
+/*
+ * GPU -> CPU copies that never wait. Requests are recorded during the frame, submitted together after the frame's
+ * command buffer (so they see everything it rendered), and their fence is polled on later frames. Once it signals the
+ * callback gets the data. When every slot is busy a request fails instead of stalling, callers just try again later.
+ */
+typedef struct {
+    ReadbackSlot slots[READBACK_MAX_REQUESTS];
+    ReadbackHandle next_handle;
+    size_t in_flight_count;
+} ReadbackQueue;
+
+ReadbackHandle readback_texture(ReadbackQueue *queue, SDL_GPUDevice *device, const SDL_GPUTextureRegion *region,
+                                SDL_GPUTextureFormat format, ReadbackCallback callback, void *user_data);
+ReadbackHandle readback_buffer(ReadbackQueue *queue, SDL_GPUDevice *device, const SDL_GPUBufferRegion *region,
+                               ReadbackCallback callback, void *user_data);
+bool readback_queue_submit(ReadbackQueue *queue, SDL_GPUDevice *device);
+void readback_queue_poll(ReadbackQueue *queue, SDL_GPUDevice *device);
+bool readback_pending(const ReadbackQueue *queue, ReadbackHandle handle);
+void readback_queue_release(ReadbackQueue *queue, SDL_GPUDevice *device);
@@ -1,8 +1,11 @@
 #include "sdl_utils.h"
 
 #include "constants.h"
+#include "profiler.h"
 
-void load_shaders(SDL_GPUDevice *device, const char *filename, SDL_GPUShader **dest) {
+// `num_samplers` is the number of texture/sampler pairs the fragment shader binds.
+void load_shaders(SDL_GPUDevice *device, const char *filename, uint32_t num_samplers, SDL_GPUShader **dest) {
+    PROFILE_BEGIN("load_shaders");
 
     if (!SDL_GetPathInfo(filename, NULL)) {
         fprintf(stdout, "File (%s) does not exist.\n", filename);
@@ -44,7 +47,7 @@ void load_shaders(SDL_GPUDevice *device, const char *filename, SDL_GPUShader **d
         .entrypoint = "fragmentShader",
         .format = format,
         .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
-        .num_samplers = 0,
+        .num_samplers = num_samplers,
         .num_uniform_buffers = 0,
         .num_storage_buffers = 0,
         .num_storage_textures = 0,
@@ -59,8 +62,13 @@ void load_shaders(SDL_GPUDevice *device, const char *filename, SDL_GPUShader **d
     dest[1] = shader;
 
     SDL_free(code);
+    PROFILE_END("load_shaders");
 }
 
+/*
+ * Blocking download, only meant for load time and tools. Anything that reads back while frames are being rendered
+ * should go through a ReadbackQueue instead.
+ */
 void map_buffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer, void *dest, size_t size) {
     SDL_GPUTransferBuffer *transfer_buffer =
         SDL_CreateGPUTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
@@ -79,8 +87,8 @@ void map_buffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer, void *dest, size_t
     SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(download_cmdbuf);
     CHECK(fence);
 
-    while (!SDL_QueryGPUFence(device, fence))
-        ;
+    // Sleeps instead of spinning on SDL_QueryGPUFence.
+    CHECK(SDL_WaitForGPUFences(device, true, &fence, 1));
 
     SDL_ReleaseGPUFence(device, fence);
 
@@ -4,5 +4,5 @@
 
 #include <stdlib.h>
 
-void load_shaders(SDL_GPUDevice *device, const char *filename, SDL_GPUShader **dest);
+void load_shaders(SDL_GPUDevice *device, const char *filename, uint32_t num_samplers, SDL_GPUShader **dest);
 void map_buffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer, void *dest, size_t size);
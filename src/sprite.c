@@ -0,0 +1,55 @@
+#include "sprite.h"
+#include "cull.h"
+
+// Writes the indices of the sprites inside the camera's frustum to `visible` and returns how many there are.
+size_t sprite_cull(const Sprite *sprites, size_t sprites_count, const Camera *camera, uint32_t *visible) {
+    Frustum frustum;
+    frustum_from_matrix(&frustum, (vec4 *)camera->mvp);
+
+    size_t visible_count = 0;
+    for (size_t i = 0; i < sprites_count; i++) {
+        const Sprite *sprite = &sprites[i];
+        // Half the diagonal, so the sphere holds the quad however it's turned.
+        float radius = 0.5f * sqrtf(sprite->size[0] * sprite->size[0] + sprite->size[1] * sprite->size[1]);
+        if (frustum_sphere_visible(&frustum, sprite->position, radius))
+            visible[visible_count++] = (uint32_t)i;
+    }
+    return visible_count;
+}
+
+/*
+ * Expands the visible sprites into quads facing the camera. `page_cursor` holds the next free quad of each page and is
+ * advanced as quads are written. `dest` is usually mapped transfer memory, so it's only ever written front to back.
+ */
+void sprite_pack(SpriteVertex *dest, const Sprite *sprites, const uint32_t *visible, size_t visible_count,
+                 size_t *page_cursor, const Camera *camera) {
+    // Rows of the view matrix are the camera's right and up vectors in world space.
+    vec3 right = {camera->view[0][0], camera->view[1][0], camera->view[2][0]};
+    vec3 up = {camera->view[0][1], camera->view[1][1], camera->view[2][1]};
+
+    for (size_t i = 0; i < visible_count; i++) {
+        const Sprite *sprite = &sprites[visible[i]];
+        SpriteVertex *quad = &dest[page_cursor[sprite->page]++ * 4];
+
+        vec3 half_right, half_up;
+        glm_vec3_scale(right, sprite->size[0] * 0.5f, half_right);
+        glm_vec3_scale(up, sprite->size[1] * 0.5f, half_up);
+
+        const float corners[4][2] = {{-1, -1}, {-1, 1}, {1, 1}, {1, -1}};
+        const float uvs[4][2] = {
+            {sprite->uv[0], sprite->uv[3]},
+            {sprite->uv[0], sprite->uv[1]},
+            {sprite->uv[2], sprite->uv[1]},
+            {sprite->uv[2], sprite->uv[3]},
+        };
+        for (int c = 0; c < 4; c++) {
+            for (int axis = 0; axis < 3; axis++)
+                quad[c].position[axis] =
+                    sprite->position[axis] + corners[c][0] * half_right[axis] + corners[c][1] * half_up[axis];
+            quad[c].position[3] = 1.0f;
+            glm_vec4_copy((float *)sprite->color, quad[c].color);
+            quad[c].uv[0] = uvs[c][0];
+            quad[c].uv[1] = uvs[c][1];
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cglm/cglm.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "camera.h"
+
+typedef struct {
+    vec3 position;
+    vec2 size;
+    // u0, v0, u1, v1 inside the atlas page.
+    vec4 uv;
+    vec4 color;
+    uint32_t page;
+} Sprite;
+
+typedef struct {
+    vec4 position, color;
+    vec2 uv;
+    vec2 padding;
+} SpriteVertex;
+
+size_t sprite_cull(const Sprite *sprites, size_t sprites_count, const Camera *camera, uint32_t *visible);
+void sprite_pack(SpriteVertex *dest, const Sprite *sprites, const uint32_t *visible, size_t visible_count,
+                 size_t *page_cursor, const Camera *camera);
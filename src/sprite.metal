@@ -0,0 +1,34 @@
+#include <metal_stdlib>
+using namespace metal;
+
+struct VertexInput {
+    float4 position [[attribute(0)]];
+    float4 color    [[attribute(1)]];
+    float2 uv       [[attribute(2)]];
+};
+
+struct FragmentInput {
+    float4 position [[position]];
+    float4 color;
+    float2 uv;
+};
+
+// Billboards are already expanded to world space quads on the CPU, so this only projects them.
+vertex FragmentInput vertexShader(
+    uint vertexId [[vertex_id]],
+    constant float4x4 *mvp [[buffer(0)]],
+    VertexInput input [[stage_in]]) {
+    FragmentInput frag = {};
+    frag.position = *mvp * input.position;
+    frag.color = input.color;
+    frag.uv = input.uv;
+    return frag;
+}
+
+// Samples the bound atlas page and tints it with the sprite color.
+fragment float4 fragmentShader(
+    FragmentInput input [[stage_in]],
+    texture2d<float> page [[texture(0)]],
+    sampler page_sampler [[sampler(0)]]) {
+    return page.sample(page_sampler, input.uv) * input.color;
+}
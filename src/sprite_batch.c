@@ -0,0 +1,234 @@
+#include "sprite_batch.h"
+#include "constants.h"
+#include "sdl_utils.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+void sprite_batch_init(SpriteBatch *batch, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device,
+                       size_t capacity) {
+    *batch = (SpriteBatch){0};
+    batch->capacity = capacity;
+    batch->sprites = malloc(sizeof(Sprite) * capacity);
+    assert(batch->sprites);
+
+    SDL_GPUShader *shaders[2] = {0};
+    load_shaders(device, "src/sprite.metal", 1, shaders);
+    SDL_GPUShader *vert_shader = shaders[0];
+    SDL_GPUShader *frag_shader = shaders[1];
+
+    SDL_GPUGraphicsPipelineCreateInfo pipeline_info = {
+        .target_info =
+            {
+                .num_color_targets = 1,
+                .color_target_descriptions =
+                    (SDL_GPUColorTargetDescription[]){{
+                        .format = color_format,
+                        .blend_state =
+                            {
+                                .enable_blend = true,
+                                .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                                .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                                .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                                .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                                .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                            },
+                    }},
+            },
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .vertex_shader = vert_shader,
+        .fragment_shader = frag_shader,
+        .vertex_input_state =
+            (SDL_GPUVertexInputState){
+                .vertex_buffer_descriptions =
+                    (SDL_GPUVertexBufferDescription[]){
+                        {
+                            .slot = 0,
+                            .pitch = sizeof(SpriteVertex),
+                            .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                            .instance_step_rate = 0,
+                        },
+                    },
+                .num_vertex_buffers = 1,
+                .vertex_attributes =
+                    (SDL_GPUVertexAttribute[]){
+                        {
+                            .location = 0,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                            .offset = offsetof(SpriteVertex, position),
+                        },
+                        {
+                            .location = 1,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+                            .offset = offsetof(SpriteVertex, color),
+                        },
+                        {
+                            .location = 2,
+                            .buffer_slot = 0,
+                            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+                            .offset = offsetof(SpriteVertex, uv),
+                        },
+                    },
+                .num_vertex_attributes = 3,
+            },
+        .rasterizer_state =
+            (SDL_GPURasterizerState){
+                .cull_mode = SDL_GPU_CULLMODE_NONE,
+                .front_face = SDL_GPU_FRONTFACE_CLOCKWISE,
+                .fill_mode = SDL_GPU_FILLMODE_FILL,
+            },
+    };
+
+    batch->pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_info);
+    CHECK(batch->pipeline);
+
+    SDL_ReleaseGPUShader(device, vert_shader);
+    SDL_ReleaseGPUShader(device, frag_shader);
+
+    batch->sampler = SDL_CreateGPUSampler(device, &(SDL_GPUSamplerCreateInfo){
+                                                      .min_filter = SDL_GPU_FILTER_LINEAR,
+                                                      .mag_filter = SDL_GPU_FILTER_LINEAR,
+                                                      .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+                                                      .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                                                      .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                                                      .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+                                                      .max_lod = 1000,
+                                                  });
+    CHECK(batch->sampler);
+
+    const size_t vertices_size = sizeof(SpriteVertex) * 4 * capacity;
+    const size_t indices_size = sizeof(uint32_t) * 6 * capacity;
+
+    batch->vertex_buffer = SDL_CreateGPUBuffer(
+        device, &(SDL_GPUBufferCreateInfo){.usage = SDL_GPU_BUFFERUSAGE_VERTEX, .size = vertices_size});
+    CHECK(batch->vertex_buffer);
+
+    batch->index_buffer = SDL_CreateGPUBuffer(
+        device, &(SDL_GPUBufferCreateInfo){.usage = SDL_GPU_BUFFERUSAGE_INDEX, .size = indices_size});
+    CHECK(batch->index_buffer);
+
+    // Sized for the index upload too, every frame after that only uses the vertex part.
+    batch->transfer_buffer =
+        SDL_CreateGPUTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
+                                                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                                                .size = SDL_max(vertices_size, indices_size),
+                                            });
+    CHECK(batch->transfer_buffer);
+
+    // The quad indices never change, so they are uploaded once.
+    {
+        uint32_t *index_data = SDL_MapGPUTransferBuffer(device, batch->transfer_buffer, false);
+        for (uint32_t i = 0; i < capacity; i++) {
+            uint32_t *quad = &index_data[i * 6];
+            quad[0] = i * 4 + 0;
+            quad[1] = i * 4 + 1;
+            quad[2] = i * 4 + 2;
+            quad[3] = i * 4 + 2;
+            quad[4] = i * 4 + 3;
+            quad[5] = i * 4 + 0;
+        }
+        SDL_UnmapGPUTransferBuffer(device, batch->transfer_buffer);
+
+        SDL_GPUCommandBuffer *upload_cmdbuf = SDL_AcquireGPUCommandBuffer(device);
+        SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmdbuf);
+
+        SDL_UploadToGPUBuffer(
+            copy_pass, &(SDL_GPUTransferBufferLocation){.transfer_buffer = batch->transfer_buffer, .offset = 0},
+            &(SDL_GPUBufferRegion){.buffer = batch->index_buffer, .offset = 0, .size = indices_size}, false);
+
+        SDL_EndGPUCopyPass(copy_pass);
+        SDL_GPUFence *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(upload_cmdbuf);
+
+        CHECK(SDL_WaitForGPUFences(device, true, &fence, 1));
+
+        SDL_ReleaseGPUFence(device, fence);
+    }
+}
+
+uint32_t sprite_batch_add_page(SpriteBatch *batch, SDL_GPUTexture *texture) {
+    assert(batch->pages_count < SPRITE_BATCH_MAX_PAGES);
+    batch->pages[batch->pages_count] = texture;
+    return (uint32_t)batch->pages_count++;
+}
+
+void sprite_batch_begin(SpriteBatch *batch) { batch->sprites_count = 0; }
+
+void sprite_batch_push(SpriteBatch *batch, const Sprite *sprite) {
+    assert(sprite->page < batch->pages_count);
+    // Past capacity sprites are dropped rather than growing the buffers mid frame.
+    if (batch->sprites_count == batch->capacity)
+        return;
+    batch->sprites[batch->sprites_count++] = *sprite;
+}
+
+/*
+ * Culls the sprites against the camera, expands the visible ones into quads facing the camera and records the copy
+ * into `cmdbuf`. Must be called before the render pass that draws the batch. Sprites are bucketed by page here, so
+ * pushing them in any order is fine. The visible list is scratch from `frame_arena`.
+ */
+void sprite_batch_upload(SpriteBatch *batch, SDL_GPUDevice *device, SDL_GPUCommandBuffer *cmdbuf,
+                         const Camera *camera, Arena *frame_arena) {
+    uint32_t *visible = arena_push_array(frame_arena, uint32_t, batch->sprites_count);
+    batch->visible_count = sprite_cull(batch->sprites, batch->sprites_count, camera, visible);
+
+    size_t cursor[SPRITE_BATCH_MAX_PAGES] = {0};
+    for (size_t i = 0; i < batch->pages_count; i++)
+        batch->page_count[i] = 0;
+    for (size_t i = 0; i < batch->visible_count; i++)
+        batch->page_count[batch->sprites[visible[i]].page]++;
+    size_t first = 0;
+    for (size_t i = 0; i < batch->pages_count; i++) {
+        batch->page_first[i] = first;
+        cursor[i] = first;
+        first += batch->page_count[i];
+    }
+
+    if (batch->visible_count == 0)
+        return;
+
+    SpriteVertex *vertex_data = SDL_MapGPUTransferBuffer(device, batch->transfer_buffer, true);
+    sprite_pack(vertex_data, batch->sprites, visible, batch->visible_count, cursor, camera);
+    SDL_UnmapGPUTransferBuffer(device, batch->transfer_buffer);
+
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(cmdbuf);
+    SDL_UploadToGPUBuffer(copy_pass, &(SDL_GPUTransferBufferLocation){.transfer_buffer = batch->transfer_buffer},
+                          &(SDL_GPUBufferRegion){
+                              .buffer = batch->vertex_buffer,
+                              .offset = 0,
+                              .size = sizeof(SpriteVertex) * 4 * batch->visible_count,
+                          },
+                          true);
+    SDL_EndGPUCopyPass(copy_pass);
+}
+
+void sprite_batch_render(SpriteBatch *batch, SDL_GPURenderPass *render_pass) {
+    if (batch->visible_count == 0)
+        return;
+
+    SDL_BindGPUGraphicsPipeline(render_pass, batch->pipeline);
+    SDL_BindGPUVertexBuffers(render_pass, 0, &(SDL_GPUBufferBinding){.buffer = batch->vertex_buffer}, 1);
+    SDL_BindGPUIndexBuffer(render_pass, &(SDL_GPUBufferBinding){.buffer = batch->index_buffer, .offset = 0},
+                           SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+    for (size_t i = 0; i < batch->pages_count; i++) {
+        if (batch->page_count[i] == 0)
+            continue;
+        SDL_BindGPUFragmentSamplers(
+            render_pass, 0, &(SDL_GPUTextureSamplerBinding){.texture = batch->pages[i], .sampler = batch->sampler},
+            1);
+        SDL_DrawGPUIndexedPrimitives(render_pass, batch->page_count[i] * 6, 1, batch->page_first[i] * 6, 0, 0);
+    }
+}
+
+void sprite_batch_release(SpriteBatch *batch, SDL_GPUDevice *device) {
+    SDL_ReleaseGPUBuffer(device, batch->vertex_buffer);
+    SDL_ReleaseGPUBuffer(device, batch->index_buffer);
+    SDL_ReleaseGPUTransferBuffer(device, batch->transfer_buffer);
+    SDL_ReleaseGPUSampler(device, batch->sampler);
+    SDL_ReleaseGPUGraphicsPipeline(device, batch->pipeline);
+    free(batch->sprites);
+    *batch = (SpriteBatch){0};
+}
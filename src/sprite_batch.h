@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+#include <cglm/cglm.h>
+
+#include "arena.h"
+#include "camera.h"
+#include "sprite.h"
+
+#define SPRITE_BATCH_MAX_PAGES 8
+
+/*
+ * Camera facing quads that are rebuilt every frame. The vertex and transfer buffers are sized for `capacity` sprites
+ * up front and cycled on every upload, so a frame never allocates or waits on the previous frame's draws.
+ */
+typedef struct {
+    SDL_GPUGraphicsPipeline *pipeline;
+    SDL_GPUBuffer *vertex_buffer;
+    SDL_GPUBuffer *index_buffer;
+    SDL_GPUTransferBuffer *transfer_buffer;
+    SDL_GPUSampler *sampler;
+    SDL_GPUTexture *pages[SPRITE_BATCH_MAX_PAGES];
+    size_t pages_count;
+
+    Sprite *sprites;
+    size_t sprites_count;
+    size_t capacity;
+
+    // Filled by sprite_batch_upload, visible sprites are grouped by page so each page is a single draw.
+    size_t page_first[SPRITE_BATCH_MAX_PAGES];
+    size_t page_count[SPRITE_BATCH_MAX_PAGES];
+    size_t visible_count;
+} SpriteBatch;
+
+void sprite_batch_init(SpriteBatch *batch, SDL_GPUTextureFormat color_format, SDL_GPUDevice *device,
+                       size_t capacity);
+uint32_t sprite_batch_add_page(SpriteBatch *batch, SDL_GPUTexture *texture);
+void sprite_batch_begin(SpriteBatch *batch);
+void sprite_batch_push(SpriteBatch *batch, const Sprite *sprite);
+void sprite_batch_upload(SpriteBatch *batch, SDL_GPUDevice *device, SDL_GPUCommandBuffer *cmdbuf,
+                         const Camera *camera, Arena *frame_arena);
+void sprite_batch_render(SpriteBatch *batch, SDL_GPURenderPass *render_pass);
+void sprite_batch_release(SpriteBatch *batch, SDL_GPUDevice *device);
@@ -0,0 +1,47 @@
+#include "swapchain.h"
+
+#include <stdio.h>
+
+void swapchain_settings_default(SwapchainSettings *settings) {
+    *settings = (SwapchainSettings){
+        .frames_in_flight = 2,
+        .present_mode = SDL_GPU_PRESENTMODE_VSYNC,
+        .composition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR,
+        .wait_for_swapchain = true,
+    };
+}
+
+/*
+ * Returns false and leaves the swapchain as it was if anything fails. `previous` is what's currently applied, used to
+ * undo the swapchain parameters when the frames in flight can't be set after them. NULL on the first call.
+ */
+bool swapchain_settings_apply(const SwapchainSettings *settings, const SwapchainSettings *previous,
+                              SDL_GPUDevice *device, SDL_Window *window) {
+    if (!SDL_WindowSupportsGPUPresentMode(device, window, settings->present_mode)) {
+        fprintf(stderr, "ERROR: present mode %d is not supported\n", settings->present_mode);
+        return false;
+    }
+    if (!SDL_WindowSupportsGPUSwapchainComposition(device, window, settings->composition)) {
+        fprintf(stderr, "ERROR: swapchain composition %d is not supported\n", settings->composition);
+        return false;
+    }
+    if (!SDL_SetGPUSwapchainParameters(device, window, settings->composition, settings->present_mode)) {
+        fprintf(stderr, "ERROR: SDL_SetGPUSwapchainParameters failed: %s\n", SDL_GetError());
+        return false;
+    }
+    if (!SDL_SetGPUAllowedFramesInFlight(device, settings->frames_in_flight)) {
+        fprintf(stderr, "ERROR: SDL_SetGPUAllowedFramesInFlight failed: %s\n", SDL_GetError());
+        if (previous && !SDL_SetGPUSwapchainParameters(device, window, previous->composition, previous->present_mode))
+            fprintf(stderr, "ERROR: restoring the swapchain parameters failed: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// `texture` is NULL when no image was free (or the window is minimized), the frame should be skipped then.
+bool swapchain_acquire(const SwapchainSettings *settings, SDL_GPUCommandBuffer *cmdbuf, SDL_Window *window,
+                       SDL_GPUTexture **texture, uint32_t *width, uint32_t *height) {
+    if (settings->wait_for_swapchain)
+        return SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, window, texture, width, height);
+    return SDL_AcquireGPUSwapchainTexture(cmdbuf, window, texture, width, height);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+typedef struct {
+    // How many frames the CPU may get ahead of the GPU, 1 to 3. Fewer is lower latency, more is smoother.
+    uint32_t frames_in_flight;
+    SDL_GPUPresentMode present_mode;
+    SDL_GPUSwapchainComposition composition;
+    // Block until a swapchain image is free, otherwise skip the frame and let the loop carry on.
+    bool wait_for_swapchain;
+} SwapchainSettings;
+
+void swapchain_settings_default(SwapchainSettings *settings);
+bool swapchain_settings_apply(const SwapchainSettings *settings, const SwapchainSettings *previous,
+                              SDL_GPUDevice *device, SDL_Window *window);
+bool swapchain_acquire(const SwapchainSettings *settings, SDL_GPUCommandBuffer *cmdbuf, SDL_Window *window,
+                       SDL_GPUTexture **texture, uint32_t *width, uint32_t *height);
@@ -0,0 +1,150 @@
+#include "texture.h"
+#include "constants.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/*
+ * Mip n averages 2^n x 2^n blocks that ignore where the images sit, so keeping neighbours apart down to the last mip
+ * takes 2^(levels - 1) texels of padding on each side. The atlas's chain is cut short to keep that small.
+ */
+#define ATLAS_MIP_LEVELS 3
+#define ATLAS_PADDING (1u << (ATLAS_MIP_LEVELS - 1))
+
+static uint32_t mip_levels(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = SDL_max(width, height); size > 1; size /= 2)
+        levels++;
+    return levels;
+}
+
+static SDL_GPUTexture *upload_texture(SDL_GPUDevice *device, SDL_GPUTextureType type, uint32_t width, uint32_t height,
+                                      uint32_t layers_count, uint32_t num_levels, const void *pixels) {
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(
+        device, &(SDL_GPUTextureCreateInfo){
+                    .type = type,
+                    .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+                    // Mip generation renders into the texture, so it needs to be a color target too.
+                    .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+                    .width = width,
+                    .height = height,
+                    .layer_count_or_depth = layers_count,
+                    .num_levels = num_levels,
+                });
+    CHECK(texture);
+
+    const size_t layer_size = (size_t)width * height * 4;
+    SDL_GPUTransferBuffer *transfer =
+        SDL_CreateGPUTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
+                                                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+                                                .size = layer_size * layers_count,
+                                            });
+    CHECK(transfer);
+    void *data = SDL_MapGPUTransferBuffer(device, transfer, false);
+    memcpy(data, pixels, layer_size * layers_count);
+    SDL_UnmapGPUTransferBuffer(device, transfer);
+
+    SDL_GPUCommandBuffer *upload_cmdbuf = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(upload_cmdbuf);
+    for (uint32_t layer = 0; layer < layers_count; layer++) {
+        SDL_UploadToGPUTexture(copy_pass,
+                               &(SDL_GPUTextureTransferInfo){
+                                   .transfer_buffer = transfer,
+                                   .offset = layer * layer_size,
+                               },
+                               &(SDL_GPUTextureRegion){
+                                   .texture = texture,
+                                   .layer = layer,
+                                   .w = width,
+                                   .h = height,
+                                   .d = 1,
+                               },
+                               false);
+    }
+    SDL_EndGPUCopyPass(copy_pass);
+
+    if (num_levels > 1)
+        SDL_GenerateMipmapsForGPUTexture(upload_cmdbuf, texture);
+
+    CHECK(SDL_SubmitGPUCommandBuffer(upload_cmdbuf));
+    SDL_ReleaseGPUTransferBuffer(device, transfer);
+
+    return texture;
+}
+
+void texture_array_init(TextureArray *array, SDL_GPUDevice *device, uint32_t width, uint32_t height,
+                        uint32_t layers_count, const void *pixels) {
+    array->width = width;
+    array->height = height;
+    array->layers_count = layers_count;
+    array->texture = upload_texture(device, SDL_GPU_TEXTURETYPE_2D_ARRAY, width, height, layers_count,
+                                    mip_levels(width, height), pixels);
+
+    // Tiles repeat across quads and are viewed at grazing angles, so trilinear with repeat.
+    array->sampler = SDL_CreateGPUSampler(device, &(SDL_GPUSamplerCreateInfo){
+                                                      .min_filter = SDL_GPU_FILTER_LINEAR,
+                                                      .mag_filter = SDL_GPU_FILTER_LINEAR,
+                                                      .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+                                                      .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+                                                      .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+                                                      .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+                                                      .max_lod = 1000,
+                                                  });
+    CHECK(array->sampler);
+}
+
+void texture_array_release(TextureArray *array, SDL_GPUDevice *device) {
+    SDL_ReleaseGPUTexture(device, array->texture);
+    SDL_ReleaseGPUSampler(device, array->sampler);
+    *array = (TextureArray){0};
+}
+
+void texture_atlas_init(TextureAtlas *atlas, uint32_t width, uint32_t height) {
+    *atlas = (TextureAtlas){0};
+    atlas->width = width;
+    atlas->height = height;
+    atlas->pixels = calloc((size_t)width * height, 4);
+    assert(atlas->pixels);
+}
+
+// Returns false when the image doesn't fit, otherwise copies it in and writes its u0, v0, u1, v1 to `uv`.
+bool texture_atlas_pack(TextureAtlas *atlas, uint32_t width, uint32_t height, const void *pixels, vec4 uv) {
+    assert(atlas->pixels);
+    if (atlas->cursor_x + width + 2 * ATLAS_PADDING > atlas->width) {
+        atlas->cursor_x = 0;
+        atlas->cursor_y += atlas->row_height;
+        atlas->row_height = 0;
+    }
+    if (atlas->cursor_x + width + 2 * ATLAS_PADDING > atlas->width ||
+        atlas->cursor_y + height + 2 * ATLAS_PADDING > atlas->height)
+        return false;
+
+    const uint32_t x = atlas->cursor_x + ATLAS_PADDING;
+    const uint32_t y = atlas->cursor_y + ATLAS_PADDING;
+    for (uint32_t row = 0; row < height; row++)
+        memcpy(&atlas->pixels[((y + row) * atlas->width + x) * 4], (const uint8_t *)pixels + row * width * 4,
+               width * 4);
+
+    uv[0] = (float)x / atlas->width;
+    uv[1] = (float)y / atlas->height;
+    uv[2] = (float)(x + width) / atlas->width;
+    uv[3] = (float)(y + height) / atlas->height;
+
+    atlas->cursor_x += width + 2 * ATLAS_PADDING;
+    atlas->row_height = SDL_max(atlas->row_height, height + 2 * ATLAS_PADDING);
+    return true;
+}
+
+// Uploads the packed images and drops the CPU copy, nothing can be packed afterwards.
+void texture_atlas_upload(TextureAtlas *atlas, SDL_GPUDevice *device) {
+    const uint32_t num_levels = SDL_min(mip_levels(atlas->width, atlas->height), ATLAS_MIP_LEVELS);
+    atlas->texture =
+        upload_texture(device, SDL_GPU_TEXTURETYPE_2D, atlas->width, atlas->height, 1, num_levels, atlas->pixels);
+    free(atlas->pixels);
+    atlas->pixels = NULL;
+}
+
+void texture_atlas_release(TextureAtlas *atlas, SDL_GPUDevice *device) {
+    SDL_ReleaseGPUTexture(device, atlas->texture);
+    free(atlas->pixels);
+    *atlas = (TextureAtlas){0};
+}
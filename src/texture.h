@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+#include <cglm/cglm.h>
+
+/*
+ * Equally sized RGBA8 images stored as the layers of one 2D array texture, with a full mip chain. Meshes pick their
+ * image with a per-vertex layer index so everything using the array can be drawn with a single binding.
+ */
+typedef struct {
+    SDL_GPUTexture *texture;
+    SDL_GPUSampler *sampler;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers_count;
+} TextureArray;
+
+/*
+ * Shelf packer for differently sized RGBA8 images. Images are packed into CPU memory first and uploaded as one 2D
+ * texture, with only as many mips as the padding between images keeps from bleeding. When an atlas is full, start
+ * another one and give it its own sprite batch page.
+ */
+typedef struct {
+    SDL_GPUTexture *texture;
+    uint32_t width;
+    uint32_t height;
+    uint8_t *pixels;
+    uint32_t cursor_x, cursor_y, row_height;
+} TextureAtlas;
+
+// `pixels` holds `layers_count` tightly packed width * height images.
+void texture_array_init(TextureArray *array, SDL_GPUDevice *device, uint32_t width, uint32_t height,
+                        uint32_t layers_count, const void *pixels);
+void texture_array_release(TextureArray *array, SDL_GPUDevice *device);
+
+void texture_atlas_init(TextureAtlas *atlas, uint32_t width, uint32_t height);
+bool texture_atlas_pack(TextureAtlas *atlas, uint32_t width, uint32_t height, const void *pixels, vec4 uv);
+void texture_atlas_upload(TextureAtlas *atlas, SDL_GPUDevice *device);
+void texture_atlas_release(TextureAtlas *atlas, SDL_GPUDevice *device);
@@ -4,26 +4,31 @@ using namespace metal;
 struct VertexInput {
     float4 position [[attribute(0)]];
     float4 color    [[attribute(1)]];
+    float4 texcoord [[attribute(2)]];
 };
 
 struct FragmentInput {
     float4 position [[position]];
     float4 color;
+    float3 texcoord;
 };
 
-// Define a vertex structure that matches your vertex buffer layout.
-// The vertex shader reads the bound vertex buffer and outputs a clip-space position.
+// Same as shader.metal, but passes the uv and texture array layer through.
 vertex FragmentInput vertexShader(
     uint vertexId [[vertex_id]],
     constant float4x4 *mvp [[buffer(0)]],
     VertexInput input [[stage_in]]) {
-    // Convert the 3D position to a 4D homogeneous coordinate.
     FragmentInput frag = {};
     frag.position = *mvp * input.position;
     frag.color = input.color;
+    frag.texcoord = input.texcoord.xyz;
     return frag;
 }
-// The fragment shader outputs a solid red color.
-fragment float4 fragmentShader(FragmentInput input [[stage_in]]) {
-    return input.color;
+
+// Every tile comes out of the same array texture, the layer picks the image.
+fragment float4 fragmentShader(
+    FragmentInput input [[stage_in]],
+    texture2d_array<float> tiles [[texture(0)]],
+    sampler tile_sampler [[sampler(0)]]) {
+    return tiles.sample(tile_sampler, input.texcoord.xy, uint(input.texcoord.z + 0.5)) * input.color;
 }